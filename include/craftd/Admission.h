@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_ADMISSION_H
+#define CRAFTD_ADMISSION_H
+
+#include <craftd/common.h>
+#include <craftd/klib/khash.h>
+
+struct _CDServer;
+
+/**
+ * Binary address (or network prefix) used as key of the admission table.
+ */
+typedef struct _CDAdmissionKey {
+    uint8_t family;
+    uint8_t network;
+    uint8_t prefix;
+    uint8_t address[16];
+} CDAdmissionKey;
+
+/**
+ * Live state of an address or a network.
+ */
+typedef struct _CDAdmissionEntry {
+    int      connected;
+    float    tokens;
+    uint64_t updated;
+} CDAdmissionEntry;
+
+static inline
+khint_t
+cd_AdmissionKeyHash (CDAdmissionKey key)
+{
+    khint_t  hash  = 2166136261U;
+    uint8_t* bytes = (uint8_t*) &key;
+
+    for (size_t i = 0; i < sizeof(key); i++) {
+        hash = (hash ^ bytes[i]) * 16777619U;
+    }
+
+    return hash;
+}
+
+#define cd_AdmissionKeyEqual(a, b) \
+    (memcmp(&(a), &(b), sizeof(CDAdmissionKey)) == 0)
+
+KHASH_INIT(cdAdmission, CDAdmissionKey, CDAdmissionEntry*, 1, cd_AdmissionKeyHash, cd_AdmissionKeyEqual);
+
+/**
+ * The Admission class.
+ *
+ * Keeps the number of live connections for every address and a token bucket
+ * for new connections for every address and every network (/24 or /64 by
+ * default), so connection storms get refused right at accept time.
+ */
+typedef struct _CDAdmission {
+    struct _CDServer* server;
+
+    khash_t(cdAdmission)* raw;
+
+    uint64_t swept;
+
+    pthread_mutex_t lock;
+} CDAdmission;
+
+/**
+ * Create an Admission table for the given server.
+ *
+ * @return The instantiated Admission object
+ */
+CDAdmission* CD_CreateAdmission (struct _CDServer* server);
+
+/**
+ * Destroy an Admission table.
+ */
+void CD_DestroyAdmission (CDAdmission* self);
+
+/**
+ * Check if a connection from the given address can be accepted and account it if so.
+ *
+ * @param address The peer address
+ *
+ * @return true if the connection is admitted, false otherwise, errno is set to
+ *         EMFILE when too many clients are connected from the address and to
+ *         EAGAIN when the address or its network is connecting too fast, or
+ *         when the table is full of addresses that can't be dropped yet
+ */
+bool CD_AdmissionAdmit (CDAdmission* self, struct sockaddr* address);
+
+/**
+ * Release a connection accounted with CD_AdmissionAdmit.
+ *
+ * @param address The peer address
+ */
+void CD_AdmissionRelease (CDAdmission* self, struct sockaddr* address);
+
+/**
+ * Drop the entries with no connected clients and a full bucket, or no bucket at all.
+ */
+void CD_AdmissionSweep (CDAdmission* self);
+
+#endif
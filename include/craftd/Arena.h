@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_ARENA_H
+#define CRAFTD_ARENA_H
+
+#include <craftd/common.h>
+
+/**
+ * Size of the blocks the Arena carves allocations from, bigger allocations get a block of their own
+ */
+#define CD_ARENA_BLOCK 16384
+
+struct _CDBuffer;
+
+typedef struct _CDArenaBlock {
+    struct _CDArenaBlock* next;
+
+    size_t length;
+    size_t size;
+
+    uint8_t data[];
+} CDArenaBlock;
+
+/**
+ * The Arena class.
+ *
+ * Bump pointer memory owned by the current thread, for transient objects
+ * that don't outlive the Job being run. Nothing is freed on its own, the
+ * Worker resets the Arena when a Job is done and code that can run outside
+ * of a Worker brackets its allocations with CD_ArenaSave/CD_ArenaRestore.
+ */
+typedef struct _CDArena {
+    CDArenaBlock* current;
+    CDArenaBlock* spare;
+
+    struct _CDBuffer* buffer;
+} CDArena;
+
+typedef struct _CDArenaMark {
+    CDArenaBlock* block;
+    size_t        length;
+} CDArenaMark;
+
+/**
+ * Get memory from the Arena of the current thread, aligned for any scalar.
+ *
+ * @param size The size of the memory
+ *
+ * @return The memory, valid until the Arena is reset or restored to an earlier mark
+ */
+void* CD_ArenaAlloc (size_t size);
+
+/**
+ * Format a string in the Arena of the current thread.
+ *
+ * @param length Where to put the length of the result, can be NULL
+ *
+ * @return The NUL terminated string
+ */
+char* CD_ArenaFormat (size_t* length, const char* format, ...);
+
+/**
+ * Remember how much of the Arena is in use.
+ */
+CDArenaMark CD_ArenaSave (void);
+
+/**
+ * Release everything allocated after the mark was saved.
+ */
+void CD_ArenaRestore (CDArenaMark mark);
+
+/**
+ * Release everything in the Arena, the Worker calls it after every Job.
+ */
+void CD_ArenaReset (void);
+
+/**
+ * Get the scratch Buffer of the current thread, it's emptied every time it's
+ * requested so the content has to be used before asking for it again.
+ *
+ * @return The empty Buffer
+ */
+struct _CDBuffer* CD_ArenaBuffer (void);
+
+/**
+ * Free the memory of the current thread Arena, call it before a thread ends.
+ */
+void CD_ArenaFlush (void);
+
+#endif
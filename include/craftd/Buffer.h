@@ -42,6 +42,17 @@ typedef struct _CDBuffer {
     bool external;
 } CDBuffer;
 
+/**
+ * Immutable reference counted content, it's added by reference to as many
+ * Buffers as needed without copying it.
+ */
+typedef struct _CDSharedBuffer {
+    int    references;
+    size_t length;
+
+    uint8_t data[];
+} CDSharedBuffer;
+
 /**
  * Create an empty Buffer object
  *
@@ -74,4 +85,29 @@ CDPointer CD_BufferRemove (CDBuffer* self, size_t length);
 
 CDBuffer* CD_BufferRemoveBuffer (CDBuffer* self);
 
+/**
+ * Add the content of a SharedBuffer by reference, the SharedBuffer is
+ * retained until the Buffer is done with it.
+ */
+void CD_BufferAddSharedBuffer (CDBuffer* self, CDSharedBuffer* data);
+
+/**
+ * Create a SharedBuffer with the content of the given Buffer, the content is copied once.
+ *
+ * @return The instantiated SharedBuffer object with one reference
+ */
+CDSharedBuffer* CD_CreateSharedBuffer (CDBuffer* buffer);
+
+/**
+ * Add a reference to a SharedBuffer.
+ *
+ * @return The SharedBuffer
+ */
+CDSharedBuffer* CD_SharedBufferRetain (CDSharedBuffer* self);
+
+/**
+ * Drop a reference to a SharedBuffer, the last one destroys it.
+ */
+void CD_SharedBufferRelease (CDSharedBuffer* self);
+
 #endif
@@ -29,6 +29,8 @@
 #include <craftd/common.h>
 
 struct _CDServer;
+struct _CDReactor;
+struct _CDJob;
 
 typedef enum _CDClientStatus {
     CDClientConnect,
@@ -38,17 +40,27 @@ typedef enum _CDClientStatus {
 } CDClientStatus;
 
 typedef struct _CDClient {
-    struct _CDServer* server;
+    struct _CDServer*  server;
+    struct _CDReactor* reactor;
 
-    char            ip[128];
-    evutil_socket_t socket;
-    CDBuffers*      buffers;
+    char                    ip[128];
+    struct sockaddr_storage address;
+    evutil_socket_t         socket;
+    CDBuffers*              buffers;
+    CDLane*                 lane;
 
     CDClientStatus status;
-    uint8_t        jobs;
+    int            references;
+
+    struct {
+        CDBuffer*     pending;
+        struct event* timer;
+        int           corked;
+    } output;
 
     struct {
         pthread_rwlock_t status;
+        pthread_mutex_t  output;
     } lock;
 
     CD_DEFINE_DYNAMIC;
@@ -69,6 +81,40 @@ CDClient* CD_CreateClient (struct _CDServer* server);
  */
 void CD_DestroyClient (CDClient* self);
 
+/**
+ * Destroy a Client object on the event loop that owns it.
+ */
+void CD_DestroyClientDeferred (CDClient* self);
+
+/**
+ * Add a reference to a Client, every queued Job holds one and the connection holds the first.
+ *
+ * @return The Client
+ */
+CDClient* CD_ClientRetain (CDClient* self);
+
+/**
+ * Add a reference to a Client unless the last one has already been dropped,
+ * for code that doesn't hold a reference of its own.
+ *
+ * @return The Client, NULL if it's being destroyed
+ */
+CDClient* CD_ClientTryRetain (CDClient* self);
+
+/**
+ * Drop a reference to a Client, when the last one is dropped the Client
+ * disconnection is queued and the Client gets destroyed after it.
+ */
+void CD_ClientRelease (CDClient* self);
+
+/**
+ * Queue a Job on the Client Lane, the Jobs of a Client run in order and
+ * the Jobs of different Clients run in parallel.
+ *
+ * @param job The Job to queue, it has to hold its own Client reference
+ */
+void CD_ClientAddJob (CDClient* self, struct _CDJob* job);
+
 /**
  * Send a raw String to a Client
  *
@@ -76,4 +122,34 @@ void CD_DestroyClient (CDClient* self);
  */
 void CD_ClientSendBuffer (CDClient* self, CDBuffer* data);
 
+/**
+ * Send a SharedBuffer to a Client, the content is queued by reference.
+ *
+ * @param data The SharedBuffer to send
+ */
+void CD_ClientSendSharedBuffer (CDClient* self, CDSharedBuffer* data);
+
+/**
+ * Make the Client coalesce its output in a pending buffer flushed after at
+ * most the given delay or when the configured size is reached.
+ *
+ * @param base The event base the flush timer runs on
+ */
+void CD_ClientCoalesceOutput (CDClient* self, struct event_base* base);
+
+/**
+ * Hold the coalesced output until the matching CD_ClientUncork, calls can be nested.
+ */
+void CD_ClientCork (CDClient* self);
+
+/**
+ * Release a CD_ClientCork and flush the output if it was the last one.
+ */
+void CD_ClientUncork (CDClient* self);
+
+/**
+ * Move the coalesced output to the socket buffer.
+ */
+void CD_ClientFlush (CDClient* self);
+
 #endif
@@ -43,6 +43,27 @@ typedef struct _CDConfig {
 
             uint16_t port;
             int      backlog;
+            int      reactors;
+
+            struct {
+                struct {
+                    float rate;
+                    int   burst;
+                } address;
+
+                struct {
+                    float   rate;
+                    int     burst;
+                    uint8_t ipv4;
+                    uint8_t ipv6;
+                } network;
+            } throttle;
+
+            struct {
+                bool coalesce;
+                int  delay;
+                int  bytes;
+            } output;
         } connection;
 
         struct {
@@ -51,6 +72,45 @@ typedef struct _CDConfig {
 
         int workers;
 
+        struct {
+            const char* workers;
+            const char* reactors;
+            const char* timeloop;
+            const char* httpd;
+        } affinity;
+
+        struct {
+            bool  enabled;
+            int   min;
+            int   max;
+            float interval;
+            float wait;
+            float high;
+            float low;
+            int   samples;
+        } autoscale;
+
+        struct {
+            float interval;
+            bool  events;
+        } stats;
+
+        struct {
+            const char* allocator;
+        } memory;
+
+        struct {
+            size_t capacity;
+            bool   stealing;
+            int    weights[3];
+
+            struct {
+                int batch;
+                int depth;
+                int packets;
+            } lane;
+        } scheduler;
+
         struct {
             struct {
                 bool        standard;
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_DEQUE_H
+#define CRAFTD_DEQUE_H
+
+#include <craftd/common.h>
+
+typedef struct _CDDequeArray {
+    size_t mask;
+
+    CDPointer item[];
+} CDDequeArray;
+
+/**
+ * The Deque class.
+ *
+ * Chase-Lev work-stealing deque, the owner thread pushes and pops at the
+ * bottom while any other thread can steal from the top. CDNull can't be stored.
+ */
+typedef struct _CDDeque {
+    CDDequeArray* array;
+    CDList*       retired;
+
+    char    _top[CD_CACHE_LINE];
+    int64_t top;
+
+    char    _bottom[CD_CACHE_LINE];
+    int64_t bottom;
+
+    char    _end[CD_CACHE_LINE];
+} CDDeque;
+
+/**
+ * Create a Deque object
+ *
+ * @param capacity The initial capacity, rounded up to a power of 2, the Deque grows as needed
+ *
+ * @return The instantiated Deque object
+ */
+CDDeque* CD_CreateDeque (size_t capacity);
+
+/**
+ * Destroy a Deque object.
+ *
+ * Keep in mind that you have to destroy the saved data yourself.
+ */
+void CD_DestroyDeque (CDDeque* self);
+
+/**
+ * Get the number of elements in the Deque, it's only a snapshot when other threads are using it
+ */
+size_t CD_DequeLength (CDDeque* self);
+
+/**
+ * Push a value at the bottom of the Deque, only the owner can call it.
+ *
+ * @param data The value to push
+ */
+void CD_DequePush (CDDeque* self, CDPointer data);
+
+/**
+ * Pop the value at the bottom of the Deque, only the owner can call it.
+ *
+ * @return The value or CDNull if the Deque is empty
+ */
+CDPointer CD_DequePop (CDDeque* self);
+
+/**
+ * Steal the value at the top of the Deque, any thread can call it.
+ *
+ * @return The value or CDNull if the Deque is empty or another thread won the race
+ */
+CDPointer CD_DequeSteal (CDDeque* self);
+
+#endif
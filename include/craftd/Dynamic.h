@@ -26,15 +26,122 @@
 #ifndef CRAFTD_DYNAMIC_H
 #define CRAFTD_DYNAMIC_H
 
-#define CD_DEFINE_DYNAMIC CDHash* _dynamic
+#define CD_DYNAMIC_MAX 1024
+
+/**
+ * A slot array, the arrays it replaced when growing are kept in previous until
+ * the Dynamic is destroyed so readers never need a lock.
+ */
+typedef struct _CDDynamicSlots {
+    struct _CDDynamicSlots* previous;
+
+    int       length;
+    CDPointer item[];
+} CDDynamicSlots;
+
+/**
+ * The Dynamic class, properties are stored in slots indexed by their atom.
+ */
+typedef struct _CDDynamic {
+    CDDynamicSlots* slots;
+
+    pthread_spinlock_t lock;
+} CDDynamic;
+
+#define CD_DEFINE_DYNAMIC CDDynamic* _dynamic
 
 #define DYNAMIC(data) ((data)->_dynamic)
 
-#define CD_CreateDynamic()  CD_CreateHash()
-#define CD_DestroyDynamic(self) CD_DestroyHash(self)
+/**
+ * Intern a property name into an atom
+ *
+ * @param name The property name
+ *
+ * @return The atom, starting from 1
+ */
+int CD_DynamicAtom (const char* name);
+
+/**
+ * Get the property name of an atom
+ *
+ * @return The name or NULL if the atom doesn't exist
+ */
+const char* CD_DynamicAtomName (int atom);
+
+/**
+ * Create a Dynamic object with a slot for every atom interned so far
+ */
+CDDynamic* CD_CreateDynamic (void);
+
+/**
+ * Destroy a Dynamic object, the stored values are yours to destroy.
+ */
+void CD_DestroyDynamic (CDDynamic* self);
+
+/**
+ * Set the value of a property
+ *
+ * @return The old value or CDNull
+ */
+CDPointer CD_DynamicPutAtom (CDDynamic* self, int atom, CDPointer value);
+
+/**
+ * Get the value of a property, it doesn't take any lock.
+ *
+ * @return The value or CDNull
+ */
+static inline
+CDPointer
+CD_DynamicGetAtom (CDDynamic* self, int atom)
+{
+    CDDynamicSlots* slots = __atomic_load_n(&self->slots, __ATOMIC_ACQUIRE);
+
+    if (atom >= slots->length) {
+        return CDNull;
+    }
+
+    return __atomic_load_n(&slots->item[atom], __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Get the value of a property by name, for code that can't use the inline
+ * functions and macros like the scripting engines.
+ *
+ * @return The value or CDNull
+ */
+CDPointer CD_DynamicGetByName (CDDynamic* self, const char* name);
+
+/**
+ * Set the value of a property by name
+ *
+ * @return The old value or CDNull
+ */
+CDPointer CD_DynamicPutByName (CDDynamic* self, const char* name, CDPointer value);
+
+/**
+ * Delete a property by name
+ *
+ * @return The old value or CDNull
+ */
+CDPointer CD_DynamicDeleteByName (CDDynamic* self, const char* name);
+
+/**
+ * Get the atom of a property name and cache it at the call site, so property has to be constant
+ */
+#define CD_DYNAMIC_ATOM(property) __extension__ ({                          \
+    static int __cached__ = 0;                                              \
+           int __atom__   = __atomic_load_n(&__cached__, __ATOMIC_RELAXED); \
+                                                                            \
+    if (__builtin_expect(__atom__ == 0, 0)) {                               \
+        __atom__ = CD_DynamicAtom(property);                                \
+        __atomic_store_n(&__cached__, __atom__, __ATOMIC_RELAXED);          \
+    }                                                                       \
+                                                                            \
+    __atom__;                                                               \
+})
 
-#define CD_DynamicGet(object, property)        CD_HashGet(DYNAMIC(object), property)
-#define CD_DynamicPut(object, property, value) CD_HashPut(DYNAMIC(object), property, (value))
-#define CD_DynamicDelete(object, property)     CD_HashDelete(DYNAMIC(object), property)
+#define CD_DynamicGet(object, property)        CD_DynamicGetAtom(DYNAMIC(object), CD_DYNAMIC_ATOM(property))
+#define CD_DynamicPut(object, property, value) CD_DynamicPutAtom(DYNAMIC(object), CD_DYNAMIC_ATOM(property), (CDPointer) (value))
+#define CD_DynamicDelete(object, property)     CD_DynamicPutAtom(DYNAMIC(object), CD_DYNAMIC_ATOM(property), CDNull)
 
 #endif
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_EPOCH_H
+#define CRAFTD_EPOCH_H
+
+#include <craftd/common.h>
+
+/**
+ * Epoch based reclamation.
+ *
+ * Readers wrap their accesses to shared data in CD_EpochEnter/CD_EpochLeave, writers
+ * swap the data with an atomic store and pass the old version to CD_EpochRetire, which
+ * destroys it once every thread that could still be reading it has left.
+ */
+
+typedef void (*CDEpochDestroyCallback) (void* pointer);
+
+/**
+ * Start reading shared data, can be nested
+ */
+void CD_EpochEnter (void);
+
+/**
+ * Stop reading shared data, pointers taken since the outermost CD_EpochEnter can't be used anymore
+ */
+void CD_EpochLeave (void);
+
+/**
+ * Destroy a pointer that is no longer reachable once no reader can hold it anymore
+ *
+ * @param pointer The pointer to destroy
+ * @param destroy The function to destroy it with
+ */
+void CD_EpochRetire (void* pointer, CDEpochDestroyCallback destroy);
+
+/**
+ * Try to advance the epoch and destroy the pointers nobody can hold anymore
+ */
+void CD_EpochCollect (void);
+
+/**
+ * Destroy every retired pointer, only safe when no thread is reading
+ */
+void CD_EpochFlush (void);
+
+#endif
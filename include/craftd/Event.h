@@ -30,15 +30,48 @@
 
 typedef bool (*CDEventCallbackFunction)();
 
+/**
+ * Profile of a registered callback, times are in nanoseconds
+ */
+typedef struct _CDEventCallbackStats {
+    uint64_t calls;
+    uint64_t interrupts;
+    uint64_t time;
+    uint64_t max;
+} CDEventCallbackStats;
+
+/**
+ * Profile of an event, times are in nanoseconds
+ */
+typedef struct _CDEventStats {
+    uint64_t dispatches;
+    uint64_t time;
+    uint64_t max;
+} CDEventStats;
+
 typedef struct _CDEventCallback {
     CDEventCallbackFunction function;
     int                     priority;
+
+    CDEventCallbackStats* stats;
 } CDEventCallback;
 
 CDEventCallback* CD_CreateEventCallback (CDEventCallbackFunction function, int priority);
 
 void CD_DestroyEventCallback (CDEventCallback* self);
 
+/**
+ * The callbacks registered for an event, sorted by priority.
+ *
+ * The arrays are never changed once published, registering and unregistering
+ * swap in a new copy and retire the old one through the Epoch.
+ */
+typedef struct _CDEventCallbacks {
+    size_t length;
+
+    CDEventCallback item[];
+} CDEventCallbacks;
+
 CDList* CD_CreateEventParameters (const char* first, ...);
 
 void CD_DestroyEventParameters (CDList* parameters);
@@ -54,101 +87,341 @@ void CD_DestroyEventParameters (CDList* parameters);
  */
 bool CD_EventProvides (CDServer* server, const char* eventName, CDList* parameters);
 
-bool cd_EventBeforeDispatch (CDServer* self, const char* eventName, ...);
+/**
+ * Maximum number of different event names in a process
+ */
+#define CD_EVENT_MAX 1024
+
+/**
+ * IDs reserved to the dispatch hooks, Event.dispatch:before and Event.dispatch:after
+ */
+#define CD_EVENT_BEFORE 1
+#define CD_EVENT_AFTER  2
+
+/**
+ * Get the ID of an event name, interning it the first time it's seen.
+ *
+ * IDs go from 1 to CD_EVENT_MAX - 1 and are the same for every Server in the process.
+ *
+ * @param eventName The event name
+ *
+ * @return The event ID
+ */
+int CD_EventID (const char* eventName);
+
+/**
+ * Get the name of an interned event
+ *
+ * @param id The event ID
+ *
+ * @return The event name or NULL if no event has that ID
+ */
+const char* CD_EventName (int id);
+
+/**
+ * Get the ID of an event name and cache it at the call site, so eventName has to be constant
+ */
+#define CD_EVENT_ID(eventName) __extension__ ({                             \
+    static int __cached__ = 0;                                              \
+           int __id__     = __atomic_load_n(&__cached__, __ATOMIC_RELAXED); \
+                                                                            \
+    if (__builtin_expect(__id__ == 0, 0)) {                                 \
+        __id__ = CD_EventID(eventName);                                     \
+        __atomic_store_n(&__cached__, __id__, __ATOMIC_RELAXED);            \
+    }                                                                       \
+                                                                            \
+    __id__;                                                                 \
+})
+
+/**
+ * Get the callbacks registered for an event ID, NULL if there are none.
+ *
+ * The array can only be used inside CD_EpochEnter/CD_EpochLeave.
+ */
+#define CD_EVENT_CALLBACKS(self, id) \
+    __atomic_load_n(&(self)->event.callbacks[id], __ATOMIC_ACQUIRE)
+
+/**
+ * Check if there are Event.dispatch:before or Event.dispatch:after callbacks
+ */
+#define CD_EVENT_HOOKED(self, hook) \
+    (__atomic_load_n(&(self)->event.hooks.hook, __ATOMIC_RELAXED) > 0)
+
+/**
+ * Get the hooks subscribed to an event ID, NULL if there are none.
+ *
+ * The array can only be used inside CD_EpochEnter/CD_EpochLeave.
+ */
+#define CD_EVENT_SUBSCRIBERS(self, id) \
+    __atomic_load_n(&(self)->event.subscribers[id], __ATOMIC_ACQUIRE)
+
+/**
+ * Get the event profiles, NULL when the profiler is disabled
+ */
+#define CD_EVENT_PROFILING(self) \
+    ((CDEventStats*) (self)->event.profile)
+
+/**
+ * Check if something has to run before the callbacks of an event ID
+ */
+#define CD_EVENT_INTERCEPTED(self, id) \
+    (CD_EVENT_HOOKED(self, before) || __atomic_load_n(&(self)->event.subscribers[id], __ATOMIC_RELAXED) != NULL)
+
+bool cd_EventBeforeDispatch (CDServer* self, int id, const char* eventName, ...);
 
 bool cd_EventAfterDispatch (CDServer* self, const char* eventName, bool interrupted, ...);
 
+void cd_EventProfileCallback (CDEventCallback* callback, uint64_t started, bool interrupted);
+
+void cd_EventProfileDispatch (CDServer* self, int id, uint64_t started);
+
 /**
  * Dispatch an event with the given name and the given parameters.
  *
  * Pay attention to the parameters you pass, those go on the stack and passing float/double
  * could get them borked. Pointers are always safe to pass.
  *
+ * The name is interned once per call site, so it has to be a constant.
+ *
  * @param eventName The name of the event to dispatch
  */
 #define CD_EventDispatch(self, eventName, ...)                                                      \
-    DO {                                                                                         \
+    DO {                                                                                            \
         assert(self);                                                                               \
         assert(eventName);                                                                          \
                                                                                                     \
         bool __interrupted__ = false;                                                               \
                                                                                                     \
-        if (!cd_EventBeforeDispatch(self, eventName, ##__VA_ARGS__)) {                              \
+        int __event__ = CD_EVENT_ID(eventName);                                                     \
+                                                                                                    \
+        if (CD_EVENT_INTERCEPTED(self, __event__) && !cd_EventBeforeDispatch(self, __event__, eventName, ##__VA_ARGS__)) { \
             break;                                                                                  \
         }                                                                                           \
                                                                                                     \
-        CDList* __callbacks__ = (CDList*) CD_HashGet(self->event.callbacks, eventName);             \
+        CD_EpochEnter();                                                                            \
                                                                                                     \
-        CD_LIST_FOREACH(__callbacks__, it) {                                                        \
-            if (!CD_ListIteratorValue(it)) {                                                        \
-                continue;                                                                           \
+        CDEventCallbacks* __callbacks__ = CD_EVENT_CALLBACKS(self, __event__);                      \
+        CDEventStats*     __profile__   = CD_EVENT_PROFILING(self);                                 \
+        uint64_t          __started__   = __profile__ ? CD_MonotonicTime() : 0;                     \
+                                                                                                    \
+        for (size_t __i__ = 0; __callbacks__ && __i__ < __callbacks__->length; __i__++) {           \
+            uint64_t __called__ = __profile__ ? CD_MonotonicTime() : 0;                             \
+            bool     __result__ = __callbacks__->item[__i__].function(self, ##__VA_ARGS__);         \
+                                                                                                    \
+            if (__profile__) {                                                                      \
+                cd_EventProfileCallback(&__callbacks__->item[__i__], __called__, !__result__);      \
             }                                                                                       \
                                                                                                     \
-            if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, ##__VA_ARGS__)) {    \
-                __interrupted__ = !CD_ListStopIterating(__callbacks__, false);                      \
+            if (!__result__) {                                                                      \
+                __interrupted__ = true;                                                             \
                 break;                                                                              \
             }                                                                                       \
         }                                                                                           \
                                                                                                     \
-        cd_EventAfterDispatch(self, eventName, __interrupted__, ##__VA_ARGS__);                     \
+        if (__profile__) {                                                                          \
+            cd_EventProfileDispatch(self, __event__, __started__);                                  \
+        }                                                                                           \
+                                                                                                    \
+        CD_EpochLeave();                                                                            \
+                                                                                                    \
+        if (CD_EVENT_HOOKED(self, after)) {                                                         \
+            cd_EventAfterDispatch(self, eventName, __interrupted__, ##__VA_ARGS__);                 \
+        }                                                                                           \
     }
 
 #define CD_EventDispatchWithResult(interrupted, self, eventName, ...)                               \
-    DO {                                                                                         \
+    DO {                                                                                            \
         assert(self);                                                                               \
         assert(eventName);                                                                          \
                                                                                                     \
         interrupted = false;                                                                        \
                                                                                                     \
-        if (!cd_EventBeforeDispatch(self, eventName, ##__VA_ARGS__)) {                              \
+        int __event__ = CD_EVENT_ID(eventName);                                                     \
+                                                                                                    \
+        if (CD_EVENT_INTERCEPTED(self, __event__) && !cd_EventBeforeDispatch(self, __event__, eventName, ##__VA_ARGS__)) { \
             break;                                                                                  \
         }                                                                                           \
                                                                                                     \
-        CDList* __callbacks__ = (CDList*) CD_HashGet(self->event.callbacks, eventName);             \
+        CD_EpochEnter();                                                                            \
+                                                                                                    \
+        CDEventCallbacks* __callbacks__ = CD_EVENT_CALLBACKS(self, __event__);                      \
+        CDEventStats*     __profile__   = CD_EVENT_PROFILING(self);                                 \
+        uint64_t          __started__   = __profile__ ? CD_MonotonicTime() : 0;                     \
+                                                                                                    \
+        for (size_t __i__ = 0; __callbacks__ && __i__ < __callbacks__->length; __i__++) {           \
+            uint64_t __called__ = __profile__ ? CD_MonotonicTime() : 0;                             \
+            bool     __result__ = __callbacks__->item[__i__].function(self, ##__VA_ARGS__);         \
                                                                                                     \
-        CD_LIST_FOREACH(__callbacks__, it) {                                                        \
-            if (!CD_ListIteratorValue(it)) {                                                        \
-                continue;                                                                           \
+            if (__profile__) {                                                                      \
+                cd_EventProfileCallback(&__callbacks__->item[__i__], __called__, !__result__);      \
             }                                                                                       \
                                                                                                     \
-            if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, ##__VA_ARGS__)) {    \
-                interrupted = !CD_ListStopIterating(__callbacks__, false);                          \
+            if (!__result__) {                                                                      \
+                interrupted = true;                                                                 \
                 break;                                                                              \
             }                                                                                       \
         }                                                                                           \
                                                                                                     \
-        cd_EventAfterDispatch(self, eventName, interrupted, ##__VA_ARGS__);                         \
+        if (__profile__) {                                                                          \
+            cd_EventProfileDispatch(self, __event__, __started__);                                  \
+        }                                                                                           \
+                                                                                                    \
+        CD_EpochLeave();                                                                            \
+                                                                                                    \
+        if (CD_EVENT_HOOKED(self, after)) {                                                         \
+            cd_EventAfterDispatch(self, eventName, interrupted, ##__VA_ARGS__);                     \
+        }                                                                                           \
     }
 
 #define CD_EventDispatchWithError(error, self, eventName, ...)                                              \
-    DO {                                                                                                 \
+    DO {                                                                                                    \
         assert(self);                                                                                       \
         assert(eventName);                                                                                  \
                                                                                                             \
         bool __interrupted__ = false;                                                                       \
              error           = CDOk;                                                                        \
                                                                                                             \
-        if (!cd_EventBeforeDispatch(self, eventName, ##__VA_ARGS__, &error)) {                              \
+        int __event__ = CD_EVENT_ID(eventName);                                                             \
+                                                                                                            \
+        if (CD_EVENT_INTERCEPTED(self, __event__) && !cd_EventBeforeDispatch(self, __event__, eventName, ##__VA_ARGS__, &error)) { \
             break;                                                                                          \
         }                                                                                                   \
                                                                                                             \
-        CDList* __callbacks__ = (CDList*) CD_HashGet(self->event.callbacks, eventName);                     \
+        CD_EpochEnter();                                                                                    \
                                                                                                             \
-        CD_LIST_FOREACH(__callbacks__, it) {                                                                \
-            if (!CD_ListIteratorValue(it)) {                                                                \
-                continue;                                                                                   \
+        CDEventCallbacks* __callbacks__ = CD_EVENT_CALLBACKS(self, __event__);                              \
+        CDEventStats*     __profile__   = CD_EVENT_PROFILING(self);                                         \
+        uint64_t          __started__   = __profile__ ? CD_MonotonicTime() : 0;                             \
+                                                                                                            \
+        for (size_t __i__ = 0; __callbacks__ && __i__ < __callbacks__->length; __i__++) {                   \
+            uint64_t __called__ = __profile__ ? CD_MonotonicTime() : 0;                                     \
+            bool     __result__ = __callbacks__->item[__i__].function(self, ##__VA_ARGS__, &error);         \
+                                                                                                            \
+            if (__profile__) {                                                                              \
+                cd_EventProfileCallback(&__callbacks__->item[__i__], __called__, !__result__);              \
             }                                                                                               \
                                                                                                             \
-            if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, ##__VA_ARGS__, &error)) {    \
-                __interrupted__ = !CD_ListStopIterating(__callbacks__, false);                              \
+            if (!__result__) {                                                                              \
+                __interrupted__ = true;                                                                     \
                 break;                                                                                      \
             }                                                                                               \
         }                                                                                                   \
                                                                                                             \
-        cd_EventAfterDispatch(self, eventName, __interrupted__, ##__VA_ARGS__, &error);                     \
+        if (__profile__) {                                                                                  \
+            cd_EventProfileDispatch(self, __event__, __started__);                                          \
+        }                                                                                                   \
+                                                                                                            \
+        CD_EpochLeave();                                                                                    \
+                                                                                                            \
+        if (CD_EVENT_HOOKED(self, after)) {                                                                 \
+            cd_EventAfterDispatch(self, eventName, __interrupted__, ##__VA_ARGS__, &error);                 \
+        }                                                                                                   \
     }
 
 
+/**
+ * Maximum number of parameters of an asynchronous dispatch
+ */
+#define CD_EVENT_ASYNC_MAX 6
+
+/**
+ * Number of Lanes the ordering keys of asynchronous dispatches are spread on
+ */
+#define CD_EVENT_LANES 64
+
+typedef CDPointer (*CDEventTypeCopy) (CDPointer value);
+
+typedef void (*CDEventTypeRelease) (CDPointer value);
+
+/**
+ * How to keep a parameter type alive until an asynchronous dispatch runs
+ */
+typedef struct _CDEventType {
+    const char* name;
+    bool        integer;
+
+    CDEventTypeCopy    copy;
+    CDEventTypeRelease release;
+} CDEventType;
+
+/**
+ * The parameter types of a provided event, resolved the first time it's dispatched asynchronously
+ */
+typedef struct _CDEventSignature {
+    size_t length;
+
+    CDEventType* item[];
+} CDEventSignature;
+
+/**
+ * A pending asynchronous dispatch
+ */
+typedef struct _CDEventAsync {
+    CDServer*         server;
+    CDEventSignature* signature;
+    int               id;
+
+    CDPointer parameters[CD_EVENT_ASYNC_MAX];
+} CDEventAsync;
+
+typedef struct _CDEventLane {
+    CDServer* server;
+    CDLane*   lane;
+} CDEventLane;
+
+/**
+ * Tell how to copy and release a parameter type for asynchronous dispatches.
+ *
+ * CDClient and CDString are known, int and bool are copied by value and the
+ * types without a copy function are passed as they are, so the caller has to
+ * make sure they outlive the dispatch. A copy function returns CDNull when the
+ * value can't be kept alive anymore, the dispatch is refused then.
+ *
+ * @param name The type name as used in CD_CreateEventParameters
+ * @param copy The function to copy or retain a value
+ * @param release The function to destroy or release the copy
+ */
+void CD_EventRegisterType (const char* name, CDEventTypeCopy copy, CDEventTypeRelease release);
+
+bool cd_EventDispatchAsync (CDServer* self, int id, const char* eventName, uint64_t key, ...);
+
+/**
+ * Wait for the pending asynchronous dispatches to run, it can't be called from a Worker.
+ *
+ * Call it before the copy and release functions of a type go away.
+ */
+void CD_EventWaitAsync (CDServer* self);
+
+/**
+ * Release the asynchronous dispatches left on the Lanes once the Workers are gone
+ */
+void CD_EventDropAsync (CDServer* self);
+
+/**
+ * Dispatch an event later on a Worker, the parameters are copied following the
+ * types the event was provided with and the Job runs with bulk priority.
+ *
+ * Use it for observers that don't have to run before the dispatching code goes
+ * on, like logging or stats. Floating point parameters aren't supported.
+ *
+ * @param eventName The name of the event to dispatch, it has to be provided
+ *
+ * @return false if the event isn't provided, has too many parameters or one of
+ *         them can't be copied
+ */
+#define CD_EventDispatchAsync(self, eventName, ...) \
+    cd_EventDispatchAsync(self, CD_EVENT_ID(eventName), eventName, 0, ##__VA_ARGS__)
+
+/**
+ * Dispatch an event later on a Worker, the dispatches with the same key run in
+ * the order they were made
+ *
+ * @param key The ordering key, 0 means no ordering
+ * @param eventName The name of the event to dispatch, it has to be provided
+ */
+#define CD_EventDispatchAsyncWithKey(self, key, eventName, ...) \
+    cd_EventDispatchAsync(self, CD_EVENT_ID(eventName), eventName, (uint64_t) (key), ##__VA_ARGS__)
+
 /**
  * Register a callback for an event.
  *
@@ -178,4 +451,53 @@ void CD_EventRegisterWithPriority (CDServer* server, const char* eventName, int
  */
 CDEventCallback** CD_EventUnregister (CDServer* server, const char* eventName, CDEventCallbackFunction callback);
 
+/**
+ * Get the profile of an event, the profiler is enabled with server.stats.events
+ *
+ * @param eventName The name of the event
+ * @param stats Where to put the profile
+ *
+ * @return false if the profiler is disabled
+ */
+bool CD_EventStats (CDServer* server, const char* eventName, CDEventStats* stats);
+
+/**
+ * Get the profiles of the callbacks registered for an event, in the order they're called
+ *
+ * @param eventName The name of the event
+ * @param functions Where to put the callback functions
+ * @param stats Where to put their profiles
+ * @param length The size of functions and stats
+ *
+ * @return The number of callbacks registered, can be bigger than length
+ */
+size_t CD_EventCallbacksStats (CDServer* server, const char* eventName, CDEventCallbackFunction* functions, CDEventCallbackStats* stats, size_t length);
+
+/**
+ * Render the profile of every dispatched event and its callbacks as text
+ *
+ * @return The report or NULL if the profiler is disabled
+ */
+CDString* CD_EventProfileReport (CDServer* server);
+
+/**
+ * Subscribe a hook to a single event.
+ *
+ * The hook is called like an Event.dispatch:before callback, with the event name and
+ * the parameters as a va_list, but only when that event is dispatched. Scripting
+ * engines use it to run only for the events their scripts handle.
+ *
+ * @param eventName The name of the event
+ * @param hook The hook to subscribe, subscribing it twice does nothing
+ */
+void CD_EventSubscribe (CDServer* server, const char* eventName, CDEventCallbackFunction hook);
+
+/**
+ * Unsubscribe a hook from an event
+ *
+ * @param eventName The name of the event, NULL to unsubscribe the hook from every event
+ * @param hook The hook to unsubscribe
+ */
+void CD_EventUnsubscribe (CDServer* server, const char* eventName, CDEventCallbackFunction hook);
+
 #endif
@@ -31,19 +31,56 @@
 
 KHASH_MAP_INIT_STR(cdHash, CDPointer);
 
+#define CD_HASH_SHARDS 16
+
+#define CD_HASH_BLOCK 4096
+
+typedef enum _CDHashFlags {
+    CDHashDefault = 0,
+
+    /** Split the Hash in CD_HASH_SHARDS shards each with its own lock, for Hashes hit by many threads */
+    CDHashStriped = 1 << 0
+} CDHashFlags;
+
 /**
- * The Hash class
+ * A block of the key arena, keys are copied in here instead of being strdup'd one by one
+ * and the block is freed when the last of them is deleted
  */
-typedef struct _CDHash {
+typedef struct _CDHashBlock {
+    struct _CDHashBlock* next;
+
+    size_t length;
+    size_t live;
+    size_t size;
+
+    char data[];
+} CDHashBlock;
+
+typedef struct _CDHashShard {
     khash_t(cdHash)* raw;
 
+    struct {
+        CDHashBlock* blocks;
+    } keys;
+
     pthread_rwlock_t lock;
+} CDHashShard;
+
+/**
+ * The Hash class
+ */
+typedef struct _CDHash {
+    size_t length;
+    size_t shards;
+
+    CDHashShard shard[];
 } CDHash;
 
 /**
  * The Hash iterator type
  */
 typedef struct _CDHashIterator {
+    size_t   shard;
     khiter_t raw;
     CDHash*  parent;
 } CDHashIterator;
@@ -55,6 +92,15 @@ typedef struct _CDHashIterator {
  */
 CDHash* CD_CreateHash (void);
 
+/**
+ * Create an Hash object with the given flags
+ *
+ * @param flags CDHashStriped to stripe the locks
+ *
+ * @return The Hash object
+ */
+CDHash* CD_CreateHashWith (CDHashFlags flags);
+
 /**
  * Shallow clone a Hash object.
  *
@@ -126,7 +172,7 @@ bool CD_HashIteratorIsEqual (CDHashIterator a, CDHashIterator b);
  *
  * @param iterator The iterator to the current position
  *
- * @return The key (string) value
+ * @return The key (string) value, valid until the key is deleted from the Hash
  */
 const char* CD_HashIteratorKey (CDHashIterator iterator);
 
@@ -199,24 +245,38 @@ CDPointer CD_HashLast (CDHash* self);
  */
 CDPointer* CD_HashClear (CDHash* self);
 
-bool CD_HashStartIterating (CDHash* self);
+/**
+ * Get an iterator to the first element, keeping its shard read locked.
+ */
+CDHashIterator CD_HashStartIterating (CDHash* self);
 
-bool CD_HashStopIterating (CDHash* self, bool stop);
+/**
+ * Get the next iterator, the read lock moves along from shard to shard and
+ * nothing is locked anymore once the end is reached.
+ */
+CDHashIterator CD_HashIteratingNext (CDHashIterator it);
+
+bool CD_HashStopIterating (CDHashIterator it, bool stop);
 
 /**
  * Iterate over the given hash
  *
+ * Only the shard the iterator is in is locked at any time, the iteration isn't
+ * a lock-free snapshot: writers to that shard wait for the iterator to move on
+ * and the shards already left behind can change meanwhile. Iterating doesn't
+ * allocate, use CD_CloneHash to iterate over a copy that can't change.
+ *
  * @parameter it The name of the iterator variable
  */
 #define CD_HASH_FOREACH(self, it)                                                   \
-    if (self && CD_HashLength(self) > 0 && CD_HashStartIterating(self))             \
-        for (CDHashIterator it = CD_HashBegin(self), __end__ = CD_HashEnd(self);    \
+    if (self && CD_HashLength(self) > 0)                                            \
+        for (CDHashIterator it = CD_HashStartIterating(self), *__it__ = &it;        \
                                                                                     \
-        CD_HashStopIterating(self, !CD_HashIteratorIsEqual(it, __end__));           \
+        CD_HashStopIterating(*__it__, it.shard < (self)->shards);                   \
                                                                                     \
-        it = CD_HashNext(it))
+        it = CD_HashIteratingNext(it))
 
 #define CD_HASH_BREAK(self) \
-    CD_HashStopIterating(self, false); break
+    CD_HashStopIterating(*__it__, false); break
 
 #endif
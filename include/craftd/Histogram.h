@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_HISTOGRAM_H
+#define CRAFTD_HISTOGRAM_H
+
+#include <craftd/common.h>
+
+/**
+ * Bucket i counts the values in [2^i, 2^(i+1)) microseconds, the first one
+ * takes everything below 2us and the last one everything above
+ */
+#define CD_HISTOGRAM_BUCKETS 32
+
+/**
+ * The Histogram class.
+ *
+ * A log2 latency histogram, it has a single writer and any number of readers
+ * taking snapshots.
+ */
+typedef struct _CDHistogram {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t max;
+
+    uint64_t bucket[CD_HISTOGRAM_BUCKETS];
+} CDHistogram;
+
+/**
+ * Clear a Histogram
+ */
+void CD_HistogramClear (CDHistogram* self);
+
+/**
+ * Record a duration, only one thread can add to a Histogram
+ *
+ * @param nanoseconds The duration
+ */
+void CD_HistogramAdd (CDHistogram* self, uint64_t nanoseconds);
+
+/**
+ * Add the content of a Histogram to another, safe while the other one is being written
+ *
+ * @param other The Histogram to add
+ */
+void CD_HistogramMerge (CDHistogram* self, CDHistogram* other);
+
+/**
+ * Get an estimate of a percentile, the upper bound of the bucket it falls in
+ *
+ * @param percentile The percentile, between 0 and 100
+ *
+ * @return The estimate in nanoseconds
+ */
+uint64_t CD_HistogramPercentile (CDHistogram* self, double percentile);
+
+/**
+ * Get the average of the recorded durations
+ *
+ * @return The average in nanoseconds
+ */
+uint64_t CD_HistogramAverage (CDHistogram* self);
+
+#endif
@@ -34,10 +34,21 @@ typedef enum _CDJobType {
     CDClientConnectJob,
     CDClientProcessJob,
     CDClientDisconnectJob,
+    CDClientLaneJob,
 
     CDCustomJob
 } CDJobType;
 
+#define CD_JOB_TYPES (CDCustomJob + 1)
+
+typedef enum _CDJobPriority {
+    CDJobHigh,
+    CDJobNormal,
+    CDJobBulk
+} CDJobPriority;
+
+#define CD_JOB_PRIORITIES 3
+
 #define CD_JOB_IS_CUSTOM(job) ( \
     job->type == CDCustomJob    \
 )
@@ -57,14 +68,18 @@ typedef struct _CDCustomJobData {
 
 typedef struct _CDClientProcessJobData {
     CDClient* client;
-    void*     packet;
+    size_t    length;
+
+    void* packets[];
 } CDClientProcessJobData;
 
 typedef struct _CDJob {
-    CDJobType type;
-    CDPointer data;
+    CDJobType     type;
+    CDPointer     data;
+    CDJobPriority priority;
 
-    bool external;
+    bool     external;
+    uint64_t queued;
 } CDJob;
 
 CDJob* CD_CreateJob (CDJobType type, CDPointer data);
@@ -79,6 +94,6 @@ CDPointer CD_DestroyJobKeepData (CDJob* job);
 
 CDCustomJobData* CD_CreateCustomJob (CDCustomJobCallback callback, CDPointer data);
 
-CDClientProcessJobData* CD_CreateClientProcessJob (CDClient* client, void* packet);
+CDClientProcessJobData* CD_CreateClientProcessJob (CDClient* client, void** packets, size_t length);
 
 #endif
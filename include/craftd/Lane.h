@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_LANE_H
+#define CRAFTD_LANE_H
+
+#include <craftd/common.h>
+
+/**
+ * The Lane class.
+ *
+ * A serial lane of values, whoever pushes on an idle Lane has to schedule
+ * its draining and only one thread drains it at a time, so the values are
+ * handled in order without holding any lock while running them.
+ */
+typedef struct _CDLane {
+    CDList* items;
+    int     length;
+    int     scheduled;
+} CDLane;
+
+/**
+ * Create a Lane object
+ *
+ * @return The instantiated Lane object
+ */
+CDLane* CD_CreateLane (void);
+
+/**
+ * Destroy a Lane object.
+ *
+ * Keep in mind that you have to destroy the saved data yourself.
+ */
+void CD_DestroyLane (CDLane* self);
+
+/**
+ * Get the number of values waiting in the Lane
+ */
+size_t CD_LaneLength (CDLane* self);
+
+/**
+ * Push a value in the Lane
+ *
+ * @param data The value to push
+ *
+ * @return true if the Lane was idle and the caller has to schedule its draining
+ */
+bool CD_LanePush (CDLane* self, CDPointer data);
+
+/**
+ * Shift the next value out of the Lane, only the thread draining it can call it.
+ *
+ * @return The value or CDNull if the Lane is empty
+ */
+CDPointer CD_LaneShift (CDLane* self);
+
+/**
+ * Give up the draining after CD_LaneShift returned CDNull.
+ *
+ * @return true if the Lane is idle, false if values were pushed in the meantime and the caller still owns the draining
+ */
+bool CD_LaneFinish (CDLane* self);
+
+#endif
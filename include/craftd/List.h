@@ -28,29 +28,33 @@
 
 #include <craftd/common.h>
 
-typedef struct _CDListItem {
-    struct _CDListItem* next;
-    struct _CDListItem* prev;
+typedef enum _CDListFlags {
+    CDListDefault = 0,
 
-    CDPointer value;
-} CDListItem;
+    /** Guard every operation with the rwlock, for Lists shared between threads */
+    CDListLocked = 1 << 0
+} CDListFlags;
 
 /**
  * The List class.
+ *
+ * Values are kept in a contiguous array, live ones are in [start, start + length),
+ * so shifting just moves start and pushing only reallocates when the array is full.
  */
 typedef struct _CDList {
-    CDListItem* head;
-    CDListItem* tail;
+    CDPointer* item;
 
+    size_t start;
     size_t length;
-    bool   changed;
+    size_t size;
 
+    CDListFlags      flags;
     pthread_rwlock_t lock;
 } CDList;
 
 typedef struct _CDListIterator {
-    CDListItem* raw;
-    CDList*     parent;
+    size_t  raw;
+    CDList* parent;
 } CDListIterator;
 
 /* Sorting the list */
@@ -61,12 +65,21 @@ typedef enum _CDListSortAlgorithm {
 typedef int8_t (*CDListCompareCallback) (CDPointer a, CDPointer b);
 
 /**
- * Create a List object
+ * Create an unlocked List object
  *
  * @return The list object
  */
 CDList* CD_CreateList (void);
 
+/**
+ * Create a List object with the given flags
+ *
+ * @param flags CDListLocked if the List is shared between threads
+ *
+ * @return The list object
+ */
+CDList* CD_CreateListWith (CDListFlags flags);
+
 /**
  * Shallow clone a List object
  *
@@ -99,7 +112,7 @@ CDListIterator CD_ListBegin (CDList* self);
 CDListIterator CD_ListEnd (CDList* self);
 
 /**
- * Get the next iterator with content, it automagically jumps empty buckets.
+ * Get the next iterator.
  *
  * @param iterator The iterator to the current position
  *
@@ -108,7 +121,7 @@ CDListIterator CD_ListEnd (CDList* self);
 CDListIterator CD_ListNext (CDListIterator it);
 
 /**
- * Get the prev iterator with content, it automagically jumps empty buckets.
+ * Get the prev iterator, going before the first element gives the end iterator.
  *
  * @param iterator The iterator to the current position
  *
@@ -241,9 +254,9 @@ bool CD_ListStopIterating (CDList* self, bool stop);
  */
 #define CD_LIST_FOREACH(self, it)                                                   \
     if (self && CD_ListLength(self) > 0 && CD_ListStartIterating(self))             \
-        for (CDListIterator it = CD_ListBegin(self), __end__ = CD_ListEnd(self);    \
+        for (CDListIterator it = CD_ListBegin(self);                                \
                                                                                     \
-        CD_ListStopIterating(self, !CD_ListIteratorIsEqual(it, __end__) && it.raw); \
+        CD_ListStopIterating(self, it.raw < (self)->length);                        \
                                                                                     \
         it = CD_ListNext(it))
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_POOL_H
+#define CRAFTD_POOL_H
+
+#include <craftd/common.h>
+
+/**
+ * Free objects a thread keeps for itself, half of them move to the depot when it's full
+ */
+#define CD_POOL_CACHE 64
+
+/**
+ * Most Pools that can be in use at the same time
+ */
+#define CD_POOL_MAX 64
+
+typedef struct _CDPoolObject {
+    struct _CDPoolObject* next;
+    struct _CDPoolObject* magazine;
+} CDPoolObject;
+
+struct _CDPool;
+
+/**
+ * Give a Pool that ran out a NULL terminated chain of fresh objects, NULL makes the allocation fail
+ */
+typedef CDPoolObject* (*CDPoolRefill) (struct _CDPool* self);
+
+/**
+ * The Pool class.
+ *
+ * Fixed size objects recycled through a thread local free list, free lists
+ * go to a shared depot in magazines of CD_POOL_CACHE / 2 objects so a thread
+ * allocating and another freeing only take the lock once in a while.
+ *
+ * Pools are meant to be static and live as long as the process.
+ */
+typedef struct _CDPool {
+    const char* name;
+    size_t      size;
+    int         index;
+
+    struct {
+        CDPoolObject* magazines;
+        size_t        length;
+    } depot;
+
+    struct {
+        uint64_t hits;
+        uint64_t misses;
+    } stats;
+
+    pthread_mutex_t lock;
+
+    CDPoolRefill refill;
+} CDPool;
+
+#define CD_POOL_INITIALIZER(name, size) \
+    CD_POOL_INITIALIZER_WITH(name, size, NULL)
+
+/**
+ * A Pool that gets its objects from refill instead of the allocator
+ */
+#define CD_POOL_INITIALIZER_WITH(name, size, refill) \
+    { name, ((size) < sizeof(CDPoolObject) ? sizeof(CDPoolObject) : (size)), 0, { NULL, 0 }, { 0, 0 }, PTHREAD_MUTEX_INITIALIZER, refill }
+
+/**
+ * Get an object from the Pool, the content is uninitialized.
+ *
+ * @return The object, NULL only if the refill of the Pool failed
+ */
+void* CD_PoolAlloc (CDPool* self);
+
+/**
+ * Give an object back to the Pool.
+ *
+ * @param data The object, it must come from the same Pool
+ */
+void CD_PoolFree (CDPool* self, void* data);
+
+/**
+ * Get an object of any size from the size class Pools, bigger objects go to the system allocator.
+ *
+ * @param size The size of the object
+ *
+ * @return The object
+ */
+void* CD_PoolsAlloc (size_t size);
+
+/**
+ * Give an object back to the size class Pools.
+ *
+ * @param data The object, it must come from CD_PoolsAlloc
+ */
+void CD_PoolsFree (void* data);
+
+/**
+ * Give the objects cached by the current thread back to the depots, call it before a thread ends.
+ */
+void CD_PoolsFlush (void);
+
+/**
+ * Get the number of Pools in use
+ */
+size_t CD_PoolsLength (void);
+
+/**
+ * Get a Pool in use, to look at its stats
+ *
+ * @param index The index of the Pool
+ *
+ * @return The Pool or NULL if the index is out of range
+ */
+CDPool* CD_PoolsGet (size_t index);
+
+#endif
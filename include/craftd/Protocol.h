@@ -30,15 +30,19 @@
 
 typedef bool  (*CDProtocolPacketParsable) (CDBuffers* buffers);
 typedef void* (*CDProtocolPacketParse)    (CDBuffers* buffers);
+typedef void  (*CDProtocolPacketDestroy)  (void* packet);
+typedef int   (*CDProtocolPacketPriority) (void* packet);
 
 typedef struct _CDProtocol {
     CDString* name;
 
     CDProtocolPacketParsable parsable;
     CDProtocolPacketParse    parse;
+    CDProtocolPacketDestroy  destroy;
+    CDProtocolPacketPriority priority;
 } CDProtocol;
 
-CDProtocol* CD_CreateProtocol (const char* name, CDProtocolPacketParsable parsable, CDProtocolPacketParse parse);
+CDProtocol* CD_CreateProtocol (const char* name, CDProtocolPacketParsable parsable, CDProtocolPacketParse parse, CDProtocolPacketDestroy destroy, CDProtocolPacketPriority priority);
 
 void CD_DestroyProtocol (CDProtocol* self);
 
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_QUEUE_H
+#define CRAFTD_QUEUE_H
+
+#include <craftd/common.h>
+
+typedef struct _CDQueueCell {
+    size_t    sequence;
+    CDPointer value;
+} CDQueueCell;
+
+/**
+ * The Queue class.
+ *
+ * Bounded lock-free multi-producer multi-consumer FIFO (Dmitry Vyukov's
+ * sequence ring), CDNull can't be stored.
+ */
+typedef struct _CDQueue {
+    size_t       mask;
+    CDQueueCell* cells;
+
+    // Written on failed CASes, kept away from what every push and shift reads
+    char _stats[CD_CACHE_LINE];
+
+    struct {
+        uint64_t contention;
+        uint64_t full;
+    } stats;
+
+    char   _head[CD_CACHE_LINE];
+    size_t head;
+
+    char   _tail[CD_CACHE_LINE];
+    size_t tail;
+
+    char   _end[CD_CACHE_LINE];
+} CDQueue;
+
+/**
+ * Create a Queue object
+ *
+ * @param capacity The capacity, rounded up to a power of 2
+ *
+ * @return The instantiated Queue object
+ */
+CDQueue* CD_CreateQueue (size_t capacity);
+
+/**
+ * Destroy a Queue object.
+ *
+ * Keep in mind that you have to destroy the saved data yourself.
+ */
+void CD_DestroyQueue (CDQueue* self);
+
+/**
+ * Get the capacity of the Queue
+ */
+size_t CD_QueueCapacity (CDQueue* self);
+
+/**
+ * Get the number of elements in the Queue, it's only a snapshot when other threads are using it
+ */
+size_t CD_QueueLength (CDQueue* self);
+
+/**
+ * Push a value at the end of the Queue.
+ *
+ * @param data The value to push
+ *
+ * @return true if the value has been pushed, false if the Queue is full
+ */
+bool CD_QueuePush (CDQueue* self, CDPointer data);
+
+/**
+ * Take the value at the start of the Queue.
+ *
+ * @return The value or CDNull if the Queue is empty
+ */
+CDPointer CD_QueueShift (CDQueue* self);
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef CRAFTD_REACTOR_H
+#define CRAFTD_REACTOR_H
+
+#include <craftd/common.h>
+
+struct _CDServer;
+
+/**
+ * The Reactor class.
+ *
+ * A Reactor owns an event_base, its own listening sockets and every Client
+ * accepted on them, so a Client's I/O always runs on the same loop.
+ */
+typedef struct _CDReactor {
+    struct _CDServer* server;
+
+    int       id;
+    pthread_t thread;
+
+    struct {
+        struct event_base* base;
+        struct event*      ipv4;
+        struct event*      ipv6;
+    } event;
+
+    struct {
+        evutil_socket_t ipv4;
+        evutil_socket_t ipv6;
+    } socket;
+} CDReactor;
+
+/**
+ * Create a Reactor object for the given server.
+ *
+ * @param server The Server the Reactor will accept Clients for
+ * @param id The index of the Reactor
+ *
+ * @return The instantiated Reactor object
+ */
+CDReactor* CD_CreateReactor (struct _CDServer* server, int id);
+
+/**
+ * Destroy a Reactor object, closing its listening sockets.
+ */
+void CD_DestroyReactor (CDReactor* self);
+
+/**
+ * Open the listening sockets of the Reactor.
+ *
+ * When SO_REUSEPORT is available every Reactor binds its own sockets and the
+ * kernel spreads new connections between them, otherwise the Reactors share
+ * the sockets of the first one.
+ *
+ * @param shared The Reactor whose sockets are shared, or NULL to bind new ones
+ *
+ * @return true if at least one socket is listening, false otherwise
+ */
+bool CD_ReactorListen (CDReactor* self, CDReactor* shared);
+
+/**
+ * Run the Reactor event loop, pass it as thread function for the additional Reactors.
+ */
+bool CD_RunReactor (CDReactor* self);
+
+bool CD_StopReactor (CDReactor* self);
+
+#endif
@@ -33,6 +33,8 @@
 #include <craftd/Protocol.h>
 #include <craftd/Plugins.h>
 #include <craftd/ScriptingEngines.h>
+#include <craftd/Admission.h>
+#include <craftd/Reactor.h>
 #include <craftd/Client.h>
 
 /**
@@ -45,26 +47,45 @@ typedef struct _CDServer {
     CDTimeLoop*         timeloop;
     CDWorkers*          workers;
     CDConfig*           config;
+    CDAdmission*        admission;
     CDPlugins*          plugins;
     CDScriptingEngines* scriptingEngines;
     CDLogger            logger;
 
     CDList* clients;
-    CDList* disconnecting;
 
     bool running;
 
     uint16_t time;
 
+    struct {
+        int         length;
+        CDReactor** item;
+    } reactors;
+
     struct {
         struct event_base* base;
-        struct event*      listener;
 
-        CDHash* callbacks;
-        CDHash* provided;
-    } event;
+        struct _CDEventCallbacks** callbacks;
+        struct _CDEventCallbacks** subscribers;
+        CDHash*                    provided;
+        struct _CDEventStats*      profile;
+
+        struct {
+            struct _CDEventSignature** signatures;
+            struct _CDEventLane*       lanes;
+
+            int            pending;
+            pthread_cond_t drained;
+        } async;
+
+        struct {
+            int before;
+            int after;
+        } hooks;
 
-    evutil_socket_t socket;
+        pthread_mutex_t lock;
+    } event;
 
     CD_DEFINE_DYNAMIC;
     CD_DEFINE_ERROR;
@@ -102,10 +123,19 @@ bool CD_StopServer (CDServer* self);
 
 void CD_ServerFlush (CDServer* self, bool now);
 
-void CD_ServerCleanDisconnects (CDServer* self);
-
 void CD_ReadFromClient (CDClient* client);
 
+/**
+ * Create a Client for an accepted connection, the Client is bound to the
+ * accepting Reactor for its whole life.
+ *
+ * @param reactor The Reactor that accepted the connection
+ * @param fd The accepted socket
+ * @param address The peer address
+ * @param length The peer address length
+ */
+void CD_ServerAccept (CDServer* self, CDReactor* reactor, evutil_socket_t fd, struct sockaddr* address, socklen_t length);
+
 #ifndef CRAFTD_SERVER_IGNORE_EXTERN
 extern CDServer* CDMainServer;
 #endif
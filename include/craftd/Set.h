@@ -13,38 +13,49 @@
 
 #include <craftd/common.h>
 
-typedef struct _CDSetMember {
-    struct _CDSetMember* next;
-    CDPointer            value;
-} CDSetMember;
-
 struct _CDSet;
 
 typedef bool         (*CDSetCompare) (struct _CDSet* self, CDPointer a, CDPointer b);
 typedef unsigned int (*CDSetHash)    (struct _CDSet* self, CDPointer pointer);
 
+/**
+ * The Set class.
+ *
+ * Members live inline in an open addressed table with linear probing, each slot
+ * has a control byte that is 0 when empty or 0x80 with 7 bits of the hash, so
+ * most mismatches are skipped without calling the compare function.
+ *
+ * A Set created without cmp and hash compares members as plain integers, 0
+ * included, so small keys like packed chunk positions need no allocation.
+ */
 typedef struct _CDSet {
     size_t       length;
     unsigned int timestamp;
 
     CDSetCompare cmp;
     CDSetHash    hash;
+    bool         integer;
 
     size_t size;
+    size_t limit;
 
-    CDSetMember** buckets;
+    uint8_t*   control;
+    CDPointer* members;
 } CDSet;
 
 typedef void (*CDSetApply) (CDSet* self, CDPointer value, CDPointer context);
 
+/**
+ * Allocate and create a new integer Set
+ */
 CDSet* CD_CreateSet (void);
 
 /**
- * Allocate and create a new Set
+ * Allocate and create a new Set, the table grows past the hint as needed
  *
  * @param hint a hint at the number of values the set may hold
- * @param cmp a comparison function for two members
- * @param hash a hash function for the member
+ * @param cmp a comparison function for two members, NULL for integers
+ * @param hash a hash function for the member, NULL for integers
  *
  * @return The instantiated Set object
  */
@@ -32,6 +32,30 @@
 struct _CDWorkers;
 struct _CDServer;
 
+/**
+ * Counters of a Worker, times are in nanoseconds.
+ *
+ * Jobs run out of a Client Lane are counted one by one, the Lane itself isn't,
+ * their wait includes the time spent on the Lane.
+ */
+typedef struct _CDWorkerStats {
+    uint64_t jobs;
+    uint64_t busy;
+    uint64_t idle;
+    uint64_t wait;
+
+    uint64_t types[CD_JOB_TYPES];
+
+    CDHistogram waiting;
+    CDHistogram running;
+
+    // Failed CASes and pushes to a full queue, filled by CD_WorkersStats out of the Workers queues
+    struct {
+        uint64_t contention;
+        uint64_t full;
+    } queues;
+} CDWorkerStats;
+
 typedef struct _CDWorker {
     struct _CDServer* server;
 
@@ -40,9 +64,15 @@ typedef struct _CDWorker {
 
     struct _CDWorkers* workers;
 
+    CDDeque* deque;
+    uint32_t seed;
+
     CDJob* job;
     bool   working;
     bool   stopped;
+
+    // Allocated by the Worker thread after pinning so it's local to its NUMA node, NULL until then
+    CDWorkerStats* stats;
 } CDWorker;
 
 /**
@@ -51,7 +81,7 @@ typedef struct _CDWorker {
 CDWorker* CD_CreateWorker (struct _CDServer* server);
 
 /**
- * Destroy a Worker object and its eventual working Job
+ * Destroy a Worker object, its eventual working Job and the Jobs left in its Deque
  *
  * @param worker The worker object to destroy
  */
@@ -67,4 +97,25 @@ bool CD_RunWorker (CDWorker* self);
  */
 bool CD_StopWorker (CDWorker* self);
 
+/**
+ * Get the Worker running in the current thread
+ *
+ * @return The Worker or NULL if the current thread isn't a Worker
+ */
+CDWorker* CD_CurrentWorker (void);
+
+/**
+ * Add a snapshot of the stats of a Worker to the given stats, safe while the Worker is running
+ *
+ * @param stats The stats to add to
+ */
+void CD_WorkerStats (CDWorker* self, CDWorkerStats* stats);
+
+/**
+ * Add some stats to others
+ *
+ * @param other The stats to add
+ */
+void CD_WorkerStatsMerge (CDWorkerStats* self, CDWorkerStats* other);
+
 #endif
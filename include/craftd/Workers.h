@@ -33,6 +33,18 @@
 
 struct _CDServer;
 
+/**
+ * Jobs of a priority class, the lock-free queue and a slower list for when it's full
+ */
+typedef struct _CDWorkersQueue {
+    CDQueue* jobs;
+
+    struct {
+        CDList* jobs;
+        int     length;
+    } overflow;
+} CDWorkersQueue;
+
 typedef struct _CDWorkers {
     struct _CDServer* server;
 
@@ -41,13 +53,37 @@ typedef struct _CDWorkers {
     size_t     length;
     CDWorker** item;
 
-    CDList* jobs;
+    CDWorkersQueue queues[CD_JOB_PRIORITIES];
+
+    struct {
+        int      sleeping;
+        uint32_t epoch;
+    } park;
+
+    CDWorkerStats retired;
+
+    struct {
+        uint64_t time;
+        uint64_t jobs;
+        uint64_t busy;
+        uint64_t wait;
+        size_t   length;
+
+        int up;
+        int down;
+    } autoscale;
 
     pthread_attr_t attributes;
 
     struct {
-        pthread_cond_t  condition;
-        pthread_mutex_t mutex;
+        pthread_cond_t   condition;
+        pthread_mutex_t  mutex;
+        pthread_rwlock_t workers;
+
+        // Under mutex, a Worker waiting to resize has to notice when it's told to stop
+        bool           resizing;
+        pthread_cond_t resize;
+        pthread_cond_t stopped;
     } lock;
 } CDWorkers;
 
@@ -57,8 +93,16 @@ void CD_DestroyWorkers (CDWorkers* self);
 
 void CD_StopWorkers (CDWorkers* self);
 
+/**
+ * Spawn new Workers in the pool
+ *
+ * @return A NULL terminated array of the new Workers, or NULL if the calling Worker is being stopped
+ */
 CDWorker** CD_SpawnWorkers (CDWorkers* self, size_t number);
 
+/**
+ * Stop and destroy the last Workers of the pool, at least one Worker is always kept
+ */
 void CD_KillWorkers (CDWorkers* self, size_t number);
 
 void CD_KillWorkersAvoid (CDWorkers* self, size_t number, CDWorker* worker);
@@ -71,6 +115,61 @@ bool CD_HasJobs (CDWorkers* self);
 
 void CD_AddJob (CDWorkers* self, CDJob* job);
 
+/**
+ * Queue a Job in the given priority class, High Jobs are picked first while Bulk
+ * Jobs still get their configured share of the picks.
+ *
+ * @param priority The priority class
+ */
+void CD_AddJobWithPriority (CDWorkers* self, CDJob* job, CDJobPriority priority);
+
+/**
+ * Get the number of Jobs waiting in the shared queues
+ */
+size_t CD_PendingJobs (CDWorkers* self);
+
 CDJob* CD_NextJob (CDWorkers* self);
 
+/**
+ * Get the next Job for a Worker, looking at its own Deque and stealing when the scheduler is in stealing mode.
+ */
+CDJob* CD_NextWorkerJob (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Park the calling Worker until a Job is added or the Worker is stopped.
+ */
+void CD_WorkersWait (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Wake up parked Workers.
+ *
+ * @param all Wake every Worker instead of one, and even if none looked parked
+ */
+void CD_WorkersWake (CDWorkers* self, bool all);
+
+/**
+ * Wait until a Worker told to stop is done with its loop.
+ */
+void CD_WorkersWaitStopped (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Mark the calling Worker as stopped and wake who's waiting for it.
+ */
+void CD_WorkersStopped (CDWorkers* self, CDWorker* worker);
+
+/**
+ * Sample the utilization and the Job wait time since the last call and grow or
+ * shrink the pool when the configured bounds are crossed for enough samples in a row.
+ */
+void CD_WorkersAutoscale (CDWorkers* self);
+
+/**
+ * Take a snapshot of the stats of every Worker the pool ever had
+ *
+ * @param stats Where to put the snapshot
+ *
+ * @return The number of running Workers
+ */
+size_t CD_WorkersStats (CDWorkers* self, CDWorkerStats* stats);
+
 #endif
@@ -78,6 +78,8 @@
 
 #define CDNull (0)
 
+#define CD_CACHE_LINE 64
+
 #include <craftd/utils.h>
 #include <craftd/memory.h>
 #include <craftd/extras.h>
@@ -85,6 +87,12 @@
 #include <craftd/Error.h>
 #include <craftd/Arithmetic.h>
 #include <craftd/List.h>
+#include <craftd/Queue.h>
+#include <craftd/Deque.h>
+#include <craftd/Lane.h>
+#include <craftd/Pool.h>
+#include <craftd/Histogram.h>
+#include <craftd/Epoch.h>
 #include <craftd/Map.h>
 #include <craftd/Hash.h>
 #include <craftd/Set.h>
@@ -96,5 +104,6 @@
 
 #include <craftd/Buffer.h>
 #include <craftd/Buffers.h>
+#include <craftd/Arena.h>
 
 #endif
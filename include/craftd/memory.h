@@ -28,6 +28,34 @@
 
 #include <craftd/common.h>
 
+/**
+ * An allocator behind CD_malloc and friends.
+ *
+ * Every allocator has to accept pointers coming from the others in free and
+ * realloc, so they can be switched while memory is in use.
+ */
+typedef struct _CDAllocator {
+    const char* name;
+
+    void* (*malloc)  (size_t size);
+    void* (*realloc) (void* pointer, size_t size);
+    void  (*free)    (void* pointer);
+} CDAllocator;
+
+/**
+ * The allocator in use, the slab one if built with --enable-slab, the system one otherwise
+ */
+extern CDAllocator* CD_Allocator;
+
+/**
+ * Switch allocator
+ *
+ * @param name "system" for libc or "slab" for size class slabs with thread caches
+ *
+ * @return true if the allocator exists and is available
+ */
+bool CD_UseAllocator (const char* name);
+
 /**
  * Simple free wrapper
  *
@@ -38,48 +66,52 @@ void
 CD_free (void* pointer)
 {
     if (pointer) {
-        free(pointer);
+        CD_Allocator->free(pointer);
     }
 }
 
 /**
- * Simple calloc wrapper w/error handling
+ * Simple malloc wrapper w/error handling
  *
- * @param number number of objects to allocate
- * @param size size of each object
+ * @param size allocation size
  *
  * @return valid pointer to heap memory
  */
 static inline
 void*
-CD_calloc (size_t number, size_t size)
+CD_malloc (size_t size)
 {
     void* pointer;
 
-    if ((pointer = calloc(number, size)) == NULL && number > 0 && size > 0) {
-        CD_abort("could not allocate memory with a calloc");
+    if ((pointer = CD_Allocator->malloc(size)) == NULL) {
+        CD_abort("could not allocate memory with a malloc");
     }
 
     return pointer;
 }
 
 /**
- * Simple malloc wrapper w/error handling
+ * Simple calloc wrapper w/error handling
  *
- * @param size allocation size
+ * @param number number of objects to allocate
+ * @param size size of each object
  *
  * @return valid pointer to heap memory
  */
 static inline
 void*
-CD_malloc (size_t size)
+CD_calloc (size_t number, size_t size)
 {
     void* pointer;
 
-    if ((pointer = malloc(size)) == NULL) {
-        CD_abort("could not allocate memory with a malloc");
+    if (size > 0 && number > SIZE_MAX / size) {
+        CD_abort("could not allocate memory with a calloc");
     }
 
+    pointer = CD_malloc(number * size);
+
+    memset(pointer, 0, number * size);
+
     return pointer;
 }
 
@@ -123,7 +155,7 @@ CD_realloc (void* pointer, size_t size)
         return NULL;
     }
 
-    if ((newPointer = realloc(pointer, size)) == NULL) {
+    if ((newPointer = CD_Allocator->realloc(pointer, size)) == NULL) {
       CD_abort("could not allocate memory with a realloc");
     }
 
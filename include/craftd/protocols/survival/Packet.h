@@ -699,7 +699,15 @@ typedef union _SVPacketDisconnect {
 SVPacket* SV_PacketFromBuffers (CDBuffers* buffers);
 
 /**
- * Destroy a Packet object
+ * Get the Job priority class a request Packet should be processed with
+ *
+ * @return A CDJobPriority
+ */
+int SV_PacketPriority (SVPacket* self);
+
+/**
+ * Destroy a Packet object, request Packets are expected to come from SV_PacketFromBuffers
+ * and go back to the packet pools
  */
 void SV_DestroyPacket (SVPacket* self);
 
@@ -726,4 +734,11 @@ CDPointer SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input);
  */
 CDBuffer* SV_PacketToBuffer (SVPacket* self);
 
+/**
+ * Add the raw packet data to an existing Buffer, like the one from CD_ArenaBuffer
+ *
+ * @return The given Buffer
+ */
+CDBuffer* SV_PacketAddToBuffer (SVPacket* self, CDBuffer* data);
+
 #endif
@@ -104,6 +104,15 @@ bool SV_StringIsValid (CDString* self);
  */
 SVString SV_StringSanitize (SVString self);
 
+/**
+ * Sanitize a String like SV_StringSanitize without creating a new String.
+ *
+ * @param output Where to put the NUL terminated result, it needs CD_StringSize(self) + 1 bytes
+ *
+ * @return The size of the result in bytes
+ */
+size_t SV_StringSanitizeInto (SVString self, char* output);
+
 SVString SV_StringColorRange (CDString* self, SVStringColor color, size_t a, size_t b);
 
 SVString SV_StringColor (CDString* self, SVStringColor color);
@@ -583,6 +592,41 @@ SV_PrecisePositionToAbsolutePosition(SVPrecisePosition position)
     };
 }
 
+/**
+ * Pack a chunk position in a single integer to use as a member of an integer CDSet.
+ *
+ * Where CDPointer is 32 bits wide each coordinate keeps only its lower 16 bits.
+ */
+static inline
+CDPointer
+SV_ChunkPositionToKey (SVChunkPosition position)
+{
+    if (sizeof(CDPointer) == 8) {
+        return (CDPointer) (((uint64_t) (uint32_t) position.x << 32) | (uint32_t) position.z);
+    }
+    else {
+        return (CDPointer) (((uint32_t) (uint16_t) position.x << 16) | (uint16_t) position.z);
+    }
+}
+
+static inline
+SVChunkPosition
+SV_KeyToChunkPosition (CDPointer key)
+{
+    if (sizeof(CDPointer) == 8) {
+        return (SVChunkPosition) {
+            .x = (int32_t) ((uint64_t) key >> 32),
+            .z = (int32_t) (uint32_t) key
+        };
+    }
+    else {
+        return (SVChunkPosition) {
+            .x = (int16_t) ((uint32_t) key >> 16),
+            .z = (int16_t) (uint16_t) key
+        };
+    }
+}
+
 #define SV_ChunkPositionEqual(a, b)     ((a.x == b.x) && (a.z == b.z))
 #define SV_BlockPositionEqual(a, b)     ((a.x == b.x) && (a.y == b.y) && (a.z == b.z))
 #define SV_AbsolutePositionEqueal(a, b) ((a.x == b.x) && (a.y == b.y) && (a.z == b.z))
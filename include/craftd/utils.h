@@ -30,6 +30,13 @@
 
 void CD_abort (const char* error, ...);
 
+/**
+ * Get a monotonic timestamp, only useful to measure intervals.
+ *
+ * @return The timestamp in nanoseconds
+ */
+uint64_t CD_MonotonicTime (void);
+
 int CD_mkdir (const char* path, mode_t mode);
 
 size_t CD_FileSize (const char* path);
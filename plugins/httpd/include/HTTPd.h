@@ -74,6 +74,13 @@ typedef struct _CDHTTPd {
         const char* root;
     } config;
 
+    struct {
+        CDWorkerStats   workers;
+        size_t          length;
+        uint64_t        time;
+        pthread_mutex_t lock;
+    } stats;
+
     pthread_t      thread;
     pthread_attr_t attributes;
 } CDHTTPd;
@@ -86,4 +93,9 @@ void* CD_RunHTTPd (CDHTTPd* self);
 
 bool CD_StopHTTPd (CDHTTPd* self);
 
+/**
+ * Keep the last Workers stats to serve them at /stats/workers
+ */
+void CD_HTTPdSaveWorkersStats (CDHTTPd* self, size_t length, CDWorkerStats* stats);
+
 #endif
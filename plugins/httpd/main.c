@@ -50,6 +50,17 @@ cdhttp_ServerStop (CDServer* server)
     return true;
 }
 
+static
+bool
+cdhttp_WorkersStats (CDServer* server, CDWorkers* workers, CDWorkerStats* stats)
+{
+    CDHTTPd* httpd = (CDHTTPd*) CD_DynamicGet(server, "HTTPd.instance");
+
+    CD_HTTPdSaveWorkersStats(httpd, __atomic_load_n(&workers->length, __ATOMIC_RELAXED), stats);
+
+    return true;
+}
+
 extern
 bool
 CD_PluginInitialize (CDPlugin* self)
@@ -60,7 +71,7 @@ CD_PluginInitialize (CDPlugin* self)
 
     CD_EventRegister(self->server, "Server.start!", cdhttp_ServerStart);
     CD_EventRegister(self->server, "Server.stop!", cdhttp_ServerStop);
-
+    CD_EventRegister(self->server, "Workers.stats", cdhttp_WorkersStats);
 
     return true;
 }
@@ -73,6 +84,7 @@ CD_PluginFinalize (CDPlugin* self)
 
     CD_EventUnregister(self->server, "Server.start!", cdhttp_ServerStart);
     CD_EventUnregister(self->server, "Server.stop!", cdhttp_ServerStop);
+    CD_EventUnregister(self->server, "Workers.stats", cdhttp_WorkersStats);
 
     return true;
 }
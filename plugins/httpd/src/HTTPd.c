@@ -25,6 +25,10 @@
 
 #include "../include/HTTPd.h"
 
+#include <craftd/Affinity.h>
+
+#include <inttypes.h>
+
 #ifdef HAVE_JSON
 #   include <jansson.h>
 #endif
@@ -116,6 +120,97 @@ cd_JSONRequest (struct evhttp_request* request, CDHTTPd* self)
 }
 #endif
 
+static
+void
+cd_WorkersStatsRequest (struct evhttp_request* request, CDHTTPd* self)
+{
+    static const char* types[] = { "connect", "process", "disconnect", "lane", "custom" };
+
+    struct evbuffer* buffer = evbuffer_new();
+    CDWorkerStats*   stats  = &self->stats.workers;
+
+    if (evhttp_request_get_command(request) != EVHTTP_REQ_GET) {
+        evhttp_send_error(request, HTTP_BADMETHOD, "Invalid request method");
+        evbuffer_free(buffer);
+
+        return;
+    }
+
+    pthread_mutex_lock(&self->stats.lock);
+    evbuffer_add_printf(buffer, "{\n  \"time\": %" PRIu64 ",\n  \"workers\": %zu,\n", self->stats.time / 1000000, self->stats.length);
+
+    evbuffer_add_printf(buffer, "  \"utilization\": %.3f,\n",
+        stats->busy + stats->idle > 0 ? (double) stats->busy / (stats->busy + stats->idle) : 0.0);
+
+    evbuffer_add_printf(buffer, "  \"jobs\": %" PRIu64 ",\n  \"busy\": %" PRIu64 ",\n  \"idle\": %" PRIu64 ",\n  \"wait\": %" PRIu64 ",\n",
+        stats->jobs, stats->busy / 1000, stats->idle / 1000, stats->wait / 1000);
+
+    evbuffer_add_printf(buffer, "  \"types\": {");
+    for (int i = 0; i < CD_JOB_TYPES; i++) {
+        evbuffer_add_printf(buffer, "%s \"%s\": %" PRIu64, i > 0 ? "," : "", types[i], stats->types[i]);
+    }
+    evbuffer_add_printf(buffer, " },\n");
+
+    evbuffer_add_printf(buffer, "  \"queues\": { \"contention\": %" PRIu64 ", \"full\": %" PRIu64 " },\n",
+        stats->queues.contention, stats->queues.full);
+
+    DO {
+        const char*  names[]      = { "waiting", "running" };
+        CDHistogram* histograms[] = { &stats->waiting, &stats->running };
+
+        for (int i = 0; i < 2; i++) {
+            evbuffer_add_printf(buffer, "  \"%s\": { \"average\": %" PRIu64 ", \"p50\": %" PRIu64 ", \"p90\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"max\": %" PRIu64 " }%s\n",
+                names[i],
+                CD_HistogramAverage(histograms[i]) / 1000,
+                CD_HistogramPercentile(histograms[i], 50) / 1000,
+                CD_HistogramPercentile(histograms[i], 90) / 1000,
+                CD_HistogramPercentile(histograms[i], 99) / 1000,
+                histograms[i]->max / 1000,
+                i == 0 ? "," : "");
+        }
+    }
+
+    evbuffer_add_printf(buffer, "}\n");
+    pthread_mutex_unlock(&self->stats.lock);
+
+    evhttp_add_header(evhttp_request_get_output_headers(request), "Content-Type", "application/json");
+
+    evhttp_send_reply(request, HTTP_OK, "OK", buffer);
+
+    evbuffer_free(buffer);
+}
+
+static
+void
+cd_EventsStatsRequest (struct evhttp_request* request, CDHTTPd* self)
+{
+    CDString*        report;
+    struct evbuffer* buffer;
+
+    if (evhttp_request_get_command(request) != EVHTTP_REQ_GET) {
+        evhttp_send_error(request, HTTP_BADMETHOD, "Invalid request method");
+
+        return;
+    }
+
+    if (!(report = CD_EventProfileReport(self->server))) {
+        evhttp_send_error(request, HTTP_NOTFOUND, "Event profiler disabled");
+
+        return;
+    }
+
+    buffer = evbuffer_new();
+
+    evbuffer_add(buffer, CD_StringContent(report), CD_StringSize(report));
+
+    evhttp_add_header(evhttp_request_get_output_headers(request), "Content-Type", "text/plain");
+
+    evhttp_send_reply(request, HTTP_OK, "OK", buffer);
+
+    evbuffer_free(buffer);
+    CD_DestroyString(report);
+}
+
 static
 void
 cd_StaticRequest (struct evhttp_request* request, CDHTTPd* self)
@@ -204,6 +299,13 @@ CD_CreateHTTPd (CDPlugin* plugin)
     evhttp_set_cb(self->event.httpd, "/rpc/json", (void (*)(struct evhttp_request*, void*)) cd_JSONRequest, self);
     #endif
 
+    memset(&self->stats, 0, sizeof(self->stats));
+    pthread_mutex_init(&self->stats.lock, NULL);
+
+    // Filled by the Workers.stats event, times are rendered in microseconds
+    evhttp_set_cb(self->event.httpd, "/stats/workers", (void (*)(struct evhttp_request*, void*)) cd_WorkersStatsRequest, self);
+    evhttp_set_cb(self->event.httpd, "/stats/events",  (void (*)(struct evhttp_request*, void*)) cd_EventsStatsRequest, self);
+
     evhttp_set_gencb(self->event.httpd, (void (*)(struct evhttp_request*, void*)) cd_StaticRequest, self);
 
     DO {
@@ -245,12 +347,16 @@ CD_DestroyHTTPd (CDHTTPd* self)
         self->event.httpd = NULL;
     }
 
+    pthread_mutex_destroy(&self->stats.lock);
+
     CD_free(self);
 }
 
 void*
 CD_RunHTTPd (CDHTTPd* self)
 {
+    CD_AffinityPin(self->server, "httpd", self->server->config->cache.affinity.httpd, -1);
+
     self->event.handle = evhttp_bind_socket_with_handle(self->event.httpd,
         self->config.connection.bind.ipv4,
         self->config.connection.port);
@@ -265,6 +371,9 @@ CD_RunHTTPd (CDHTTPd* self)
 
     CD_EventDispatch(self->server, "HTTPd.stopped", self);
 
+    CD_ArenaFlush();
+    CD_PoolsFlush();
+
     return NULL;
 }
 
@@ -277,3 +386,16 @@ CD_StopHTTPd (CDHTTPd* self)
 
     return event_base_loopexit(self->event.base, &interval);
 }
+
+void
+CD_HTTPdSaveWorkersStats (CDHTTPd* self, size_t length, CDWorkerStats* stats)
+{
+    assert(self);
+    assert(stats);
+
+    pthread_mutex_lock(&self->stats.lock);
+    self->stats.workers = *stats;
+    self->stats.length  = length;
+    self->stats.time    = CD_MonotonicTime();
+    pthread_mutex_unlock(&self->stats.lock);
+}
@@ -99,16 +99,15 @@ cdsurvival_SendChunk (CDServer* server, SVPlayer* player, SVChunkPosition* coord
 
 static
 void
-cdsurvival_ChunkRadiusUnload (CDSet* self, SVChunkPosition* coord, SVPlayer* player)
+cdsurvival_ChunkRadiusUnload (CDSet* self, CDPointer key, SVPlayer* player)
 {
     assert(self);
-    assert(coord);
     assert(player);
 
     DO {
         SVPacketPreChunk pkt = {
             .response = {
-                .position = *coord,
+                .position = SV_KeyToChunkPosition(key),
                 .mode = false
             }
         };
@@ -117,29 +116,18 @@ cdsurvival_ChunkRadiusUnload (CDSet* self, SVChunkPosition* coord, SVPlayer* pla
 
         SV_PlayerSendPacketAndCleanData(player, &response);
     }
-
-    CD_free(coord);
 }
 
 static
 void
-cdsurvival_ChunkMemberFree (CDSet* self, SVChunkPosition* coord, void* _)
+cdsurvival_ChunkRadiusLoad (CDSet* self, CDPointer key, SVPlayer* player)
 {
-    assert(self);
-    assert(coord);
-
-    CD_free(coord);
-}
+    SVChunkPosition coord = SV_KeyToChunkPosition(key);
 
-static
-void
-cdsurvival_ChunkRadiusLoad (CDSet* self, SVChunkPosition* coord, SVPlayer* player)
-{
     assert(self);
-    assert(coord);
     assert(player);
 
-    cdsurvival_SendChunk(player->client->server, player, coord);
+    cdsurvival_SendChunk(player->client->server, player, &coord);
 }
 
 static
@@ -148,16 +136,17 @@ cdsurvival_SendChunkRadius (SVPlayer* player, SVChunkPosition* area, int radius)
 {
     CDSet* loadedChunks = (CDSet*) CD_DynamicGet(player, "Player.loadedChunks");
     CDSet* oldChunks    = loadedChunks;
-    CDSet* newChunks    = CD_CreateSetWith(400, (CDSetCompare) SV_CompareChunkPosition, (CDSetHash) SV_HashChunkPosition);
+    CDSet* newChunks    = CD_CreateSetWith(400, NULL, NULL);
 
     for (int x = -radius; x < radius; x++) {
         for (int z = -radius; z < radius; z++) {
             if ((x * x + z * z) <= (radius * radius)) {
-                SVChunkPosition* coord = CD_malloc(sizeof(SVChunkPosition));
-                coord->x          = x + area->x;
-                coord->z          = z + area->z;
+                SVChunkPosition coord = {
+                    .x = x + area->x,
+                    .z = z + area->z
+                };
 
-                CD_SetPut(newChunks, (CDPointer) coord);
+                CD_SetPut(newChunks, SV_ChunkPositionToKey(coord));
             }
         }
     }
@@ -221,14 +210,21 @@ void
 cdsurvival_SendPacketToAllInRegion(SVPlayer *player, SVPacket *pkt)
 {
   CDList *seenPlayers = (CDList *) CD_DynamicGet(player, "Player.seenPlayers");
+  CDBuffer *buffer = SV_PacketToBuffer(pkt);
+  CDSharedBuffer *shared = CD_CreateSharedBuffer(buffer);
 
   CD_LIST_FOREACH(seenPlayers, it)
   {
-    if ( player != (SVPlayer *) CD_ListIteratorValue(it) )
-      SV_PlayerSendPacket( (SVPlayer *) CD_ListIteratorValue(it), pkt );
-    else
+    SVPlayer *other = (SVPlayer *) CD_ListIteratorValue(it);
+
+    if ( player == other )
       CERR("We have a player with himself in the List????");
+    else if ( other->client )
+      CD_ClientSendSharedBuffer( other->client, shared );
   }
+
+  CD_SharedBufferRelease(shared);
+  CD_DestroyBuffer(buffer);
 }
 
 static
@@ -728,14 +724,13 @@ cdsurvival_PlayerLogin (CDServer* server, SVPlayer* player, int status)
         SV_PlayerSendPacket(player, &packet);
     }
 
-    SV_WorldBroadcastMessage(player->world, SV_StringColor(CD_CreateStringFromFormat("%s has joined the game",
-                CD_StringContent(player->username)), SVColorYellow));
-
+    // The join message doesn't have to hold up the login, keyed by Client so it can't pass a later
+    // asynchronous event of the same Player, the Jobs on the Client Lane aren't ordered with it
+    CD_EventDispatchAsyncWithKey(server, player->client, "Player.joined", player);
 
-    CD_DynamicPut(player, "Player.loadedChunks", (CDPointer) CD_CreateSetWith(
-        400, (CDSetCompare) SV_CompareChunkPosition, (CDSetHash) SV_HashChunkPosition));
+    CD_DynamicPut(player, "Player.loadedChunks", (CDPointer) CD_CreateSetWith(400, NULL, NULL));
 
-    CD_DynamicPut(player, "Player.seenPlayers", (CDPointer) CD_CreateList());
+    CD_DynamicPut(player, "Player.seenPlayers", (CDPointer) CD_CreateListWith(CDListLocked));
 
     SVChunkPosition playerChunk = SV_PrecisePositionToChunkPosition(player->entity.position);
 
@@ -744,6 +739,34 @@ cdsurvival_PlayerLogin (CDServer* server, SVPlayer* player, int status)
     return true;
 }
 
+static
+bool
+cdsurvival_PlayerJoined (CDServer* server, SVPlayer* player)
+{
+    SV_WorldBroadcastMessage(player->world, SV_StringColor(CD_CreateStringFromFormat("%s has joined the game",
+                CD_StringContent(player->username)), SVColorYellow));
+
+    return true;
+}
+
+/**
+ * A Player lives as long as its Client, asynchronous dispatches keep the Client
+ */
+static
+CDPointer
+cdsurvival_RetainPlayer (SVPlayer* player)
+{
+    // A Player whose Client is on its way out can't be dispatched anymore
+    return CD_ClientTryRetain(player->client) ? (CDPointer) player : CDNull;
+}
+
+static
+void
+cdsurvival_ReleasePlayer (SVPlayer* player)
+{
+    CD_ClientRelease(player->client);
+}
+
 static
 bool
 cdsurvival_PlayerLogout (CDServer* server, SVPlayer* player)
@@ -773,7 +796,6 @@ cdsurvival_PlayerLogout (CDServer* server, SVPlayer* player)
     CDSet* chunks = (CDSet*) CD_DynamicDelete(player, "Player.loadedChunks");
 
     if (chunks) {
-        CD_SetMap(chunks, (CDSetApply) cdsurvival_ChunkMemberFree, CDNull);
         CD_DestroySet(chunks);
     }
 
@@ -93,13 +93,15 @@ static
 void
 cdsurvival_KeepAlive (void* _, void* __, CDServer* server)
 {
-    SVPacket  packet = { SVResponse, SVKeepAlive, CDNull };
-    CDBuffer* buffer = SV_PacketToBuffer(&packet);
+    SVPacket        packet = { SVResponse, SVKeepAlive, CDNull };
+    CDBuffer*       buffer = SV_PacketToBuffer(&packet);
+    CDSharedBuffer* shared = CD_CreateSharedBuffer(buffer);
 
     CD_LIST_FOREACH(server->clients, it) {
-        CD_ClientSendBuffer((CDClient*) CD_ListIteratorValue(it), buffer);
+        CD_ClientSendSharedBuffer((CDClient*) CD_ListIteratorValue(it), shared);
     }
 
+    CD_SharedBufferRelease(shared);
     CD_DestroyBuffer(buffer);
 }
 
@@ -201,12 +203,16 @@ CD_PluginInitialize (CDPlugin* self)
     CD_EventRegister(self->server, "Client.process", cdsurvival_ClientProcess);
     CD_EventRegister(self->server, "Client.processed", cdsurvival_ClientProcessed);
     CD_EventRegister(self->server, "Player.login", cdsurvival_PlayerLogin);
+    CD_EventRegister(self->server, "Player.joined", cdsurvival_PlayerJoined);
     CD_EventRegister(self->server, "Player.logout", cdsurvival_PlayerLogout);
     CD_EventRegister(self->server, "Player.destroy", cdsurvival_PlayerDestroy);
     CD_EventRegister(self->server, "Client.kick", cdsurvival_ClientKick);
     CD_EventRegister(self->server, "Client.disconnect", (CDEventCallbackFunction) cdsurvival_ClientDisconnect);
 
+    CD_EventRegisterType("SVPlayer", (CDEventTypeCopy) cdsurvival_RetainPlayer, (CDEventTypeRelease) cdsurvival_ReleasePlayer);
+
     CD_EventProvides(self->server, "Player.login", CD_CreateEventParameters("SVPlayer", "bool", NULL));
+    CD_EventProvides(self->server, "Player.joined", CD_CreateEventParameters("SVPlayer", NULL));
     CD_EventProvides(self->server, "Player.logout", CD_CreateEventParameters("SVPlayer", "bool", NULL));
     CD_EventProvides(self->server, "Player.chat", CD_CreateEventParameters("SVPlayer", "CDString", NULL));
 
@@ -235,11 +241,17 @@ CD_PluginFinalize (CDPlugin* self)
     CD_EventUnregister(self->server, "Client.process", cdsurvival_ClientProcess);
     CD_EventUnregister(self->server, "Client.processed", cdsurvival_ClientProcessed);
     CD_EventUnregister(self->server, "Player.login", cdsurvival_PlayerLogin);
+    CD_EventUnregister(self->server, "Player.joined", cdsurvival_PlayerJoined);
     CD_EventUnregister(self->server, "Player.logout", cdsurvival_PlayerLogout);
     CD_EventUnregister(self->server, "Player.destroy", cdsurvival_PlayerDestroy);
     CD_EventUnregister(self->server, "Client.kick", cdsurvival_ClientKick);
     CD_EventUnregister(self->server, "Client.disconnect", (CDEventCallbackFunction) cdsurvival_ClientDisconnect);
 
+    // The pending dispatches hold Players copied with the functions going away with the plugin
+    CD_EventWaitAsync(self->server);
+
+    CD_EventRegisterType("SVPlayer", NULL, NULL);
+
     pthread_mutex_destroy(&_lock.login);
 
     return true;
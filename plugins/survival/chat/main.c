@@ -34,7 +34,7 @@ static CDRegexp*    _ChatCommandRegex;
  * Sends a message to all connected to the server.
  * The given message string is destroyed.
  */
-static void svchat_SendMessage (CDServer* server, CDString* message);
+static void svchat_SendMessage (CDServer* server, const char* message, size_t length);
 static bool svchat_PlayerChat  (CDServer* server, SVPlayer* player, CDString* message);
 static bool svchat_ChatCommand (CDServer* server, SVPlayer* player, CDString* command, CDString* args);
 
@@ -114,11 +114,11 @@ CD_PluginFinalize (CDPlugin* self)
 
 /**
  * Sends a message to all connected to the server.
- * The given message string is destroyed.
+ * The message is only wrapped, not copied, so it can live in the Arena.
  */
 static
 void
-svchat_SendMessage(CDServer* server, CDString* message)
+svchat_SendMessage(CDServer* server, const char* message, size_t length)
 {
     assert(server);
     CDList* worlds = (CDList*) CD_DynamicGet(server, "World.list");
@@ -126,9 +126,8 @@ svchat_SendMessage(CDServer* server, CDString* message)
     CD_LIST_FOREACH(worlds, it) {
         SVWorld* world = (SVWorld*) CD_ListIteratorValue(it);
 
-        SV_WorldBroadcastMessage(world, CD_CloneString(message));
+        SV_WorldBroadcastMessage(world, CD_CreateStringFromBuffer(message, length));
     }
-    CD_DestroyString(message);
 }
 
 static
@@ -174,16 +173,20 @@ svchat_ChatCommand (CDServer* server, SVPlayer* player, CDString* command, CDStr
         CD_StringContent(player->username), CD_StringContent(command), CD_StringContent(args));
 
     if (CD_StringIsEqual(command, "")) {
-        svchat_SendMessage(server, 
-            CD_CreateStringFromFormat("<%s> %s",
-                CD_StringContent(player->username),
-                CD_StringContent(args)));
+        size_t length;
+        char*  message = CD_ArenaFormat(&length, "<%s> %s",
+            CD_StringContent(player->username),
+            CD_StringContent(args));
+
+        svchat_SendMessage(server, message, length);
     }
     else if (CD_StringIsEqual(command, "me")) {
-        svchat_SendMessage(server,
-            CD_CreateStringFromFormat("* %s %s",
-                CD_StringContent(player->username),
-                CD_StringContent(args)));
+        size_t length;
+        char*  message = CD_ArenaFormat(&length, "* %s %s",
+            CD_StringContent(player->username),
+            CD_StringContent(args));
+
+        svchat_SendMessage(server, message, length);
     }
     else if (CD_StringIsEqual(command, "tell")) {
         //Lookup player
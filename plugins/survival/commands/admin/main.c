@@ -297,7 +297,7 @@ CD_PluginInitialize (CDPlugin* self)
         }
     }
 
-    _tickets = CD_CreateList();
+    _tickets = CD_CreateListWith(CDListLocked);
 
     CD_DynamicPut(self->server, "Admin.tickets", (CDPointer) _tickets);
 
@@ -199,7 +199,7 @@ cdnbt_PersistenceObserve (CDServer* server, const char* type, const char* name)
     CDList* names = (CDList*) CD_HashGet(observing, type);
 
     if (names == NULL) {
-        CD_HashPut(observing, type, (CDPointer) (names = CD_CreateList()));
+        CD_HashPut(observing, type, (CDPointer) (names = CD_CreateListWith(CDListLocked)));
     }
 
     CD_ListPushIf(names, (CDPointer) name, (CDListCompareCallback)cdnbt_NameNotObserved);
@@ -220,7 +220,7 @@ cdnbt_PersistenceWatch (CDServer* server, CDPointer object, const char* type)
     CDList* objects = (CDList*) CD_HashGet(watching, type);
 
     if (objects == NULL) {
-        CD_HashPut(watching, type, (CDPointer) (objects = CD_CreateList()));
+        CD_HashPut(watching, type, (CDPointer) (objects = CD_CreateListWith(CDListLocked)));
     }
 
     CD_ListPushIf(objects, object, (CDListCompareCallback) cdnbt_ObjectNotWatched);
@@ -176,9 +176,130 @@ cdtest_Hash_foreach (void* data)
     }
 }
 
+static
+void
+cdtest_Hash_striped (void* data)
+{
+    CDHash* hash  = CD_CreateHashWith(CDHashStriped);
+    char    name[16];
+    int     total = 0;
+
+    for (int i = 1; i <= 100; i++) {
+        snprintf(name, sizeof(name), "key%d", i);
+        CD_HashPut(hash, name, i);
+    }
+
+    for (int i = 2; i <= 100; i += 2) {
+        snprintf(name, sizeof(name), "key%d", i);
+        tt_int_op((int) CD_HashDelete(hash, name), ==, i);
+    }
+
+    tt_int_op(CD_HashLength(hash), ==, 50);
+    tt_int_op((int) CD_HashGet(hash, "key99"), ==, 99);
+
+    CD_HASH_FOREACH(hash, it) {
+        total += CD_HashIteratorValue(it);
+    }
+
+    tt_int_op(total, ==, 2500);
+
+    end: {
+        CD_DestroyHash(hash);
+    }
+}
+
+static
+void
+cdtest_Hash_blocks (void* data)
+{
+    CDHash*     hash = CD_CreateHashWith(CDHashStriped);
+    const char* kept = NULL;
+    char        name[64];
+
+    // Enough keys to fill several blocks in every shard
+    for (int i = 0; i < 4000; i++) {
+        snprintf(name, sizeof(name), "a rather long key to fill the blocks %d", i);
+        CD_HashPut(hash, name, i + 1);
+    }
+
+    CD_HASH_FOREACH(hash, it) {
+        if (CD_HashIteratorValue(it) == 3001) {
+            kept = CD_HashIteratorKey(it);
+        }
+    }
+
+    tt_assert(kept);
+
+    for (int i = 0; i < 3000; i++) {
+        snprintf(name, sizeof(name), "a rather long key to fill the blocks %d", i);
+        tt_int_op((int) CD_HashDelete(hash, name), ==, i + 1);
+    }
+
+    // Deleting the others doesn't move the keys left
+    tt_str_op(kept, ==, "a rather long key to fill the blocks 3000");
+    tt_int_op(CD_HashLength(hash), ==, 1000);
+
+    CD_HASH_FOREACH(hash, it) {
+        snprintf(name, sizeof(name), "a rather long key to fill the blocks %d", (int) CD_HashIteratorValue(it) - 1);
+        tt_str_op(CD_HashIteratorKey(it), ==, name);
+    }
+
+    for (int i = 3000; i < 4000; i++) {
+        snprintf(name, sizeof(name), "a rather long key to fill the blocks %d", i);
+        tt_int_op((int) CD_HashGet(hash, name), ==, i + 1);
+    }
+
+    end: {
+        CD_DestroyHash(hash);
+    }
+}
+
 static struct testcase_t cd_utils_Hash_tests[] = {
     { "put", cdtest_Hash_put, },
     { "foreach", cdtest_Hash_foreach, },
+    { "striped", cdtest_Hash_striped, },
+    { "blocks", cdtest_Hash_blocks, },
+
+    END_OF_TESTCASES
+};
+
+typedef struct _CDTestDynamic {
+    CD_DEFINE_DYNAMIC;
+} CDTestDynamic;
+
+static
+void
+cdtest_Dynamic_put (void* data)
+{
+    CDTestDynamic object;
+
+    DYNAMIC(&object) = CD_CreateDynamic();
+
+    tt_int_op(CD_DynamicGet(&object, "Test.value"), ==, CDNull);
+    tt_int_op(CD_DynamicPut(&object, "Test.value", 42), ==, CDNull);
+    tt_int_op(CD_DynamicPut(&object, "Test.value", 23), ==, 42);
+    tt_int_op(CD_DynamicGet(&object, "Test.value"), ==, 23);
+
+    // Interned after the object was created, so the slots have to grow
+    for (int i = 0; i < 64; i++) {
+        char name[16];
+
+        snprintf(name, sizeof(name), "Test.value%d", i);
+        CD_DynamicPutAtom(DYNAMIC(&object), CD_DynamicAtom(name), i + 1);
+    }
+
+    tt_int_op(CD_DynamicGetAtom(DYNAMIC(&object), CD_DynamicAtom("Test.value63")), ==, 64);
+    tt_int_op(CD_DynamicDelete(&object, "Test.value"), ==, 23);
+    tt_int_op(CD_DynamicGet(&object, "Test.value"), ==, CDNull);
+    tt_str_op(CD_DynamicAtomName(CD_DynamicAtom("Test.value")), ==, "Test.value");
+
+    end: {
+        CD_DestroyDynamic(DYNAMIC(&object));
+    }
+}
+
+static struct testcase_t cd_utils_Dynamic_tests[] = {
+    { "put", cdtest_Dynamic_put, },
 
     END_OF_TESTCASES
 };
@@ -388,6 +509,29 @@ cdtest_List_insertSorted (void *data)
     }
 }
 
+static
+void
+cdtest_List_deleteAll (void* data)
+{
+    CDList* list = CD_CreateList();
+
+    CD_ListPush(list, 23);
+    CD_ListPush(list, 42);
+    CD_ListPush(list, 23);
+    CD_ListPush(list, 911);
+
+    tt_int_op(CD_ListShift(list), ==, 23);
+    tt_int_op(CD_ListDeleteAll(list, 23), ==, 23);
+    tt_int_op(CD_ListLength(list), ==, 2);
+    tt_assert(!CD_ListContains(list, 23));
+    tt_int_op(CD_ListFirst(list), ==, 42);
+    tt_int_op(CD_ListLast(list), ==, 911);
+
+    end: {
+        CD_DestroyList(list);
+    }
+}
+
 static struct testcase_t cd_utils_List_tests[] = {
     { "push", cdtest_List_push, },
     { "push if", cdtest_List_pushIf, },
@@ -395,6 +539,7 @@ static struct testcase_t cd_utils_List_tests[] = {
     { "clear", cdtest_List_clear, },
     { "sort", cdtest_List_sort, },
     { "insert sorted", cdtest_List_insertSorted, },
+    { "delete all", cdtest_List_deleteAll, },
 
     END_OF_TESTCASES
 };
@@ -453,10 +598,287 @@ cdtest_Set_length (void* data)
     }
 }
 
+static
+void
+cdtest_Set_chunks (void* data)
+{
+    CDSet* set = CD_CreateSetWith(4, NULL, NULL);
+
+    for (int x = -20; x < 20; x++) {
+        for (int z = -20; z < 20; z++) {
+            CD_SetPut(set, SV_ChunkPositionToKey((SVChunkPosition) { x, z }));
+        }
+    }
+
+    tt_int_op(CD_SetLength(set), ==, 1600);
+    tt_assert(CD_SetHas(set, SV_ChunkPositionToKey((SVChunkPosition) { 0, 0 })));
+    tt_assert(CD_SetHas(set, SV_ChunkPositionToKey((SVChunkPosition) { -20, 19 })));
+    tt_assert(!CD_SetHas(set, SV_ChunkPositionToKey((SVChunkPosition) { 20, 0 })));
+
+    SVChunkPosition position = SV_KeyToChunkPosition(SV_ChunkPositionToKey((SVChunkPosition) { -3, 7 }));
+
+    tt_int_op(position.x, ==, -3);
+    tt_int_op(position.z, ==, 7);
+
+    end: {
+        CD_DestroySet(set);
+    }
+}
+
 static struct testcase_t cd_utils_Set_tests[] = {
     { "put",    cdtest_Set_put, },
     { "delete", cdtest_Set_delete, },
     { "length", cdtest_Set_length, },
+    { "chunks", cdtest_Set_chunks, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Queue_fifo (void* data)
+{
+    CDQueue* queue = CD_CreateQueue(3);
+
+    tt_int_op(CD_QueueCapacity(queue), ==, 4);
+
+    for (int i = 1; i <= 4; i++) {
+        tt_assert(CD_QueuePush(queue, i));
+    }
+
+    tt_assert(!CD_QueuePush(queue, 5));
+    tt_int_op(CD_QueueLength(queue), ==, 4);
+
+    for (int i = 1; i <= 4; i++) {
+        tt_int_op(CD_QueueShift(queue), ==, i);
+    }
+
+    tt_int_op(CD_QueueShift(queue), ==, CDNull);
+    tt_assert(CD_QueuePush(queue, 6));
+    tt_int_op(CD_QueueShift(queue), ==, 6);
+
+    end: {
+        CD_DestroyQueue(queue);
+    }
+}
+
+static struct testcase_t cd_utils_Queue_tests[] = {
+    { "fifo", cdtest_Queue_fifo, },
+
+    END_OF_TESTCASES
+};
+
+static CDPool cdtest_pool = CD_POOL_INITIALIZER("test", 24);
+
+static
+void
+cdtest_Pool_recycle (void* data)
+{
+    void* first = CD_PoolAlloc(&cdtest_pool);
+    void* small = NULL;
+    void* big;
+
+    CD_PoolFree(&cdtest_pool, first);
+
+    tt_ptr_op(CD_PoolAlloc(&cdtest_pool), ==, first);
+    tt_int_op(cdtest_pool.stats.misses, ==, 1);
+
+    small = CD_PoolsAlloc(10);
+    big   = CD_PoolsAlloc(4096);
+
+    memset(small, 0, 10);
+    memset(big, 0, 4096);
+
+    CD_PoolsFree(small);
+    CD_PoolsFree(big);
+
+    tt_ptr_op(CD_PoolsAlloc(10), ==, small);
+
+    end: {
+        CD_PoolFree(&cdtest_pool, first);
+        CD_PoolsFree(small);
+    }
+}
+
+static
+void
+cdtest_Pool_slab (void* data)
+{
+    const char* previous = CD_Allocator->name;
+    char*       before   = CD_malloc(24);
+    char*       small    = NULL;
+
+    if (!CD_UseAllocator("slab")) {
+        tt_skip();
+    }
+
+    small = CD_malloc(24);
+    strcpy(small, "slab");
+
+    small = CD_realloc(small, 4096);
+    tt_str_op(small, ==, "slab");
+
+    // Memory from the other allocator can still be freed
+    CD_free(before);
+    before = NULL;
+
+    end: {
+        CD_free(before);
+        CD_free(small);
+
+        CD_UseAllocator(previous);
+    }
+}
+
+static struct testcase_t cd_utils_Pool_tests[] = {
+    { "recycle", cdtest_Pool_recycle, },
+    { "slab",    cdtest_Pool_slab, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Arena_restore (void* data)
+{
+    CDArenaMark mark  = CD_ArenaSave();
+    char*       first = CD_ArenaAlloc(3);
+    char*       after;
+    size_t      length;
+
+    tt_int_op((uintptr_t) CD_ArenaAlloc(8) % 16, ==, 0);
+
+    // Bigger than a block, it gets one of its own
+    memset(CD_ArenaAlloc(CD_ARENA_BLOCK * 2), 0, CD_ARENA_BLOCK * 2);
+
+    tt_str_op(CD_ArenaFormat(&length, "<%s> %d", "test", 42), ==, "<test> 42");
+    tt_int_op(length, ==, 9);
+
+    CD_ArenaRestore(mark);
+
+    after = CD_ArenaAlloc(3);
+    tt_ptr_op(after, ==, first);
+
+    end: {
+        CD_ArenaReset();
+    }
+}
+
+static struct testcase_t cd_utils_Arena_tests[] = {
+    { "restore", cdtest_Arena_restore, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Lane_schedule (void* data)
+{
+    CDLane* lane = CD_CreateLane();
+
+    tt_assert(CD_LanePush(lane, 1));
+    tt_assert(!CD_LanePush(lane, 2));
+    tt_int_op(CD_LaneLength(lane), ==, 2);
+
+    tt_int_op(CD_LaneShift(lane), ==, 1);
+    tt_int_op(CD_LaneShift(lane), ==, 2);
+    tt_int_op(CD_LaneShift(lane), ==, CDNull);
+
+    tt_assert(!CD_LanePush(lane, 3));
+    tt_assert(!CD_LaneFinish(lane));
+    tt_int_op(CD_LaneShift(lane), ==, 3);
+    tt_assert(CD_LaneFinish(lane));
+
+    tt_assert(CD_LanePush(lane, 4));
+    tt_int_op(CD_LaneShift(lane), ==, 4);
+
+    end: {
+        CD_DestroyLane(lane);
+    }
+}
+
+static struct testcase_t cd_utils_Lane_tests[] = {
+    { "schedule", cdtest_Lane_schedule, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Histogram_percentile (void* data)
+{
+    CDHistogram histogram;
+    CDHistogram merged;
+
+    CD_HistogramClear(&histogram);
+    CD_HistogramClear(&merged);
+
+    tt_int_op(CD_HistogramPercentile(&histogram, 50), ==, 0);
+
+    for (int i = 0; i < 90; i++) {
+        CD_HistogramAdd(&histogram, 3000);
+    }
+
+    for (int i = 0; i < 10; i++) {
+        CD_HistogramAdd(&histogram, 100000);
+    }
+
+    tt_int_op(histogram.count, ==, 100);
+    tt_int_op(CD_HistogramPercentile(&histogram, 50), ==, 4000);
+    tt_int_op(CD_HistogramPercentile(&histogram, 95), ==, 128000);
+    tt_int_op(CD_HistogramAverage(&histogram), ==, 12700);
+
+    CD_HistogramMerge(&merged, &histogram);
+    CD_HistogramMerge(&merged, &histogram);
+
+    tt_int_op(merged.count, ==, 200);
+    tt_int_op(merged.max, ==, 100000);
+
+    end: {
+        return;
+    }
+}
+
+static struct testcase_t cd_utils_Histogram_tests[] = {
+    { "percentile", cdtest_Histogram_percentile, },
+
+    END_OF_TESTCASES
+};
+
+static
+void
+cdtest_Buffer_shared (void* data)
+{
+    CDBuffer*       buffer = CD_CreateBuffer();
+    CDBuffer*       first  = CD_CreateBuffer();
+    CDBuffer*       second = CD_CreateBuffer();
+    CDSharedBuffer* shared;
+
+    CD_BufferAdd(buffer, (CDPointer) "lol wut", 7);
+
+    shared = CD_CreateSharedBuffer(buffer);
+
+    CD_BufferAddSharedBuffer(first, shared);
+    CD_BufferAddSharedBuffer(second, shared);
+
+    tt_int_op(shared->references, ==, 3);
+    tt_int_op(CD_BufferLength(first), ==, 7);
+    tt_int_op(memcmp(evbuffer_pullup(second->raw, -1), "lol wut", 7), ==, 0);
+
+    CD_BufferDrain(first, 7);
+
+    tt_int_op(shared->references, ==, 2);
+
+    end: {
+        CD_SharedBufferRelease(shared);
+        CD_DestroyBuffer(buffer);
+        CD_DestroyBuffer(first);
+        CD_DestroyBuffer(second);
+    }
+}
+
+static struct testcase_t cd_utils_Buffer_tests[] = {
+    { "shared", cdtest_Buffer_shared, },
 
     END_OF_TESTCASES
 };
@@ -549,9 +971,16 @@ static struct testgroup_t cd_groups[] = {
     { "utils/String/UTF8/",      cd_utils_String_UTF8_tests },
     { "utils/String/Minecraft/", cd_utils_String_Minecraft_tests },
     { "utils/Hash/",             cd_utils_Hash_tests },
+    { "utils/Dynamic/",          cd_utils_Dynamic_tests },
     { "utils/Map/",              cd_utils_Map_tests },
     { "utils/List/",             cd_utils_List_tests },
     { "utils/Set/",              cd_utils_Set_tests },
+    { "utils/Queue/",            cd_utils_Queue_tests },
+    { "utils/Lane/",             cd_utils_Lane_tests },
+    { "utils/Pool/",             cd_utils_Pool_tests },
+    { "utils/Arena/",            cd_utils_Arena_tests },
+    { "utils/Histogram/",        cd_utils_Histogram_tests },
+    { "utils/Buffer/",           cd_utils_Buffer_tests },
     { "utils/Regexp/",           cd_utils_Regexp_tests },
 
 //    { "events/", cd_events_tests },
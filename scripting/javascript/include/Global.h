@@ -37,8 +37,14 @@ static JSClass Global_class = {
 
 JSBool Global_include (JSContext* context, uintN argc, jsval* argv);
 
+JSBool Global_subscribe (JSContext* context, uintN argc, jsval* argv);
+
+JSBool Global_unsubscribe (JSContext* context, uintN argc, jsval* argv);
+
 static JSFunctionSpec Global_functions[] = {
-    JS_FS("include", Global_include, 0, 0),
+    JS_FS("include",     Global_include,     0, 0),
+    JS_FS("subscribe",   Global_subscribe,   1, 0),
+    JS_FS("unsubscribe", Global_unsubscribe, 1, 0),
 
     JS_FS_END
 };
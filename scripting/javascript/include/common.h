@@ -30,4 +30,6 @@
 
 #include <craftd/Server.h>
 
+bool cdjs_EventDispatcher (CDServer* server, const char* event, va_list args);
+
 #endif
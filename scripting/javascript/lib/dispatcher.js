@@ -8,6 +8,8 @@ Craftd.register = function (name) {
   for (let i = 1; i < arguments.length; i++) {
     Craftd.events[name].push(arguments[i]);
   }
+
+  Craftd.subscribe(name);
 }
 
 Craftd.unregister = function (name) {
@@ -35,4 +37,8 @@ Craftd.unregister = function (name) {
       return true;
     });
   }
+
+  if (Craftd.events[name].length == 0) {
+    Craftd.unsubscribe(name);
+  }
 }
@@ -66,7 +66,7 @@ CD_ScriptingEngineInitialize (CDScriptingEngine* self)
     CD_DynamicPut(self->server, "JavaScript.contextes", (CDPointer) contextes);
     CD_DynamicPut(self->server, "JavaScript.context",   (CDPointer) context);
 
-    CD_EventRegister(self->server, "Event.dispatch:before", cdjs_EventDispatcher);
+    // Craftd.register subscribes the dispatcher to the events the scripts handle
 
     return true;
 }
@@ -75,7 +75,7 @@ extern
 bool
 CD_ScriptingEngineFinalize (CDScriptingEngine* self)
 {
-    CD_EventUnregister(self->server, "Event.dispatch:before", cdjs_EventDispatcher);
+    CD_EventUnsubscribe(self->server, NULL, cdjs_EventDispatcher);
 
     CDMap* contextes = (CDMap*) CD_DynamicDelete(self->server, "JavaScript.contextes");
 
@@ -40,6 +40,8 @@ cdjs_InitializeGlobal (CDServer* server, JSContext* context)
     JS_InitCTypesClass(context, self);
     #endif
 
+    JS_SetPrivate(context, self, server);
+
     if (!JS_DefineFunctions(context, self, Global_functions)) {
         return JS_FALSE;
     }
@@ -62,3 +64,44 @@ Global_include (JSContext* context, uintN argc, jsval* argv)
 
     return JS_TRUE;
 }
+
+static
+JSBool
+cdjs_Subscription (JSContext* context, uintN argc, jsval* argv, bool subscribe)
+{
+    CDServer* server = (CDServer*) JS_GetPrivate(context, JS_GetGlobalObject(context));
+
+    for (uintN i = 0; i < argc; i++) {
+        JSString* string = JS_ValueToString(context, JS_ARGV(context, argv)[i]);
+        char*     name;
+
+        if (!string || !(name = JS_EncodeString(context, string))) {
+            return JS_FALSE;
+        }
+
+        if (subscribe) {
+            CD_EventSubscribe(server, name, cdjs_EventDispatcher);
+        }
+        else {
+            CD_EventUnsubscribe(server, name, cdjs_EventDispatcher);
+        }
+
+        JS_free(context, name);
+    }
+
+    JS_SET_RVAL(context, argv, JSVAL_VOID);
+
+    return JS_TRUE;
+}
+
+JSBool
+Global_subscribe (JSContext* context, uintN argc, jsval* argv)
+{
+    return cdjs_Subscription(context, argc, argv, true);
+}
+
+JSBool
+Global_unsubscribe (JSContext* context, uintN argc, jsval* argv)
+{
+    return cdjs_Subscription(context, argc, argv, false);
+}
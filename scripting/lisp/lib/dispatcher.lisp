@@ -18,13 +18,16 @@
 
 (defun register (name callback &optional priority)
   (let ((callbacks (get-callbacks name)))
-    (set-callbacks name (sort (append (list (list callback (or priority 0))) callbacks) #'sort-callbacks))))
+    (set-callbacks name (sort (append (list (list callback (or priority 0))) callbacks) #'sort-callbacks))
+    (c-subscribe name)))
 
 (defun unregister (name &optional callback)
   (let ((callbacks (get-callbacks name)))
     (set-callbacks name (if callback
       (remove-if #'(lambda (element) (equal (first element) callback)) callbacks)
-      nil))))
+      nil))
+    (unless (get-callbacks name)
+      (c-unsubscribe name))))
 
 (defun fire (name &rest rest)
   (dolist (callback (get-callbacks name))
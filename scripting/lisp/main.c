@@ -59,13 +59,64 @@ cdcl_EventDispatcher (CDServer* server, const char* event, va_list args)
     return true;
 }
 
+static CDServer* cdcl_Server = NULL;
+
+/**
+ * Find the provided event a keyword refers to, the reader upcases the names
+ */
+static
+const char*
+cdcl_EventFromKeyword (cl_object keyword)
+{
+    cl_object   name   = si_coerce_to_base_string(cl_string(keyword));
+    const char* result = NULL;
+
+    CD_HASH_FOREACH(cdcl_Server->event.provided, it) {
+        if (strcasecmp(CD_HashIteratorKey(it), (const char*) name->base_string.self) == 0) {
+            result = CD_HashIteratorKey(it);
+        }
+    }
+
+    return result;
+}
+
+static
+cl_object
+cdcl_Subscribe (cl_object keyword)
+{
+    const char* event = cdcl_EventFromKeyword(keyword);
+
+    if (!event) {
+        return Cnil;
+    }
+
+    CD_EventSubscribe(cdcl_Server, event, cdcl_EventDispatcher);
+
+    return Ct;
+}
+
+static
+cl_object
+cdcl_Unsubscribe (cl_object keyword)
+{
+    const char* event = cdcl_EventFromKeyword(keyword);
+
+    if (!event) {
+        return Cnil;
+    }
+
+    CD_EventUnsubscribe(cdcl_Server, event, cdcl_EventDispatcher);
+
+    return Ct;
+}
+
 extern
 bool
 CD_ScriptingEngineInitialize (CDScriptingEngine* self)
 {
     self->description = CD_CreateStringFromCString("Common LISP scripting");
 
-    CD_DynamicPut(self->server, "LISP.threads", (CDPointer) CD_CreateList());
+    CD_DynamicPut(self->server, "LISP.threads", (CDPointer) CD_CreateListWith(CDListLocked));
 
     int          argc = 1;
     const char** argv = CD_malloc(sizeof(char*));
@@ -131,12 +182,19 @@ CD_ScriptingEngineInitialize (CDScriptingEngine* self)
 
     cdcl_eval("(defparameter craftd::*server* (uffi:make-pointer %ld 'craftd::server))", (CDPointer) self->server);
 
+    // craftd:register subscribes the dispatcher to the events the scripts handle
+    cdcl_Server = self->server;
+
+    ecl_def_c_function(cl_intern(2, cdcl_str("C-SUBSCRIBE"), cl_find_package(cdcl_str("CRAFTD"))),
+        (cl_objectfn_fixed) cdcl_Subscribe, 1);
+
+    ecl_def_c_function(cl_intern(2, cdcl_str("C-UNSUBSCRIBE"), cl_find_package(cdcl_str("CRAFTD"))),
+        (cl_objectfn_fixed) cdcl_Unsubscribe, 1);
+
     C_FOREACH(script, C_PATH(self->config, "scripts")) {
         cdcl_eval("(asdf:load-system \"%s\")", C_TO_STRING(script));
     }
 
-    CD_EventRegister(self->server, "Event.dispatch:before", cdcl_EventDispatcher);
-
     if (C_TO_BOOL(C_PATH(self->config, "shell"))) {
         cdcl_eval("ashella");
     }
@@ -148,7 +206,7 @@ extern
 bool
 CD_ScriptingEngineFinalize (CDScriptingEngine* self)
 {
-    CD_EventUnregister(self->server, "Event.dispatch:before", cdcl_EventDispatcher);
+    CD_EventUnsubscribe(self->server, NULL, cdcl_EventDispatcher);
 
     CD_DestroyList((CDList*) CD_DynamicDelete(self->server, "LISP.threads"));
 
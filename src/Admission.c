@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Admission.h>
+#include <craftd/Server.h>
+#include <craftd/Logger.h>
+
+/* Past this many entries the table is swept on admission instead of waiting for the interval */
+#define CD_ADMISSION_MAX_ENTRIES 65536
+
+/* A full table is swept again on admission at most this often, in nanoseconds, new addresses are refused meanwhile */
+#define CD_ADMISSION_SWEEP_BACKOFF 1000000000ULL
+
+static
+bool
+cd_AdmissionKey (struct sockaddr* address, bool network, uint8_t ipv4, uint8_t ipv6, CDAdmissionKey* key)
+{
+    size_t length;
+
+    memset(key, 0, sizeof(CDAdmissionKey));
+
+    key->family  = address->sa_family;
+    key->network = network;
+
+    if (address->sa_family == AF_INET) {
+        length      = 4;
+        key->prefix = network ? ipv4 : 32;
+
+        memcpy(key->address, &((struct sockaddr_in*) address)->sin_addr, length);
+    }
+    else if (address->sa_family == AF_INET6) {
+        length      = 16;
+        key->prefix = network ? ipv6 : 128;
+
+        memcpy(key->address, &((struct sockaddr_in6*) address)->sin6_addr, length);
+    }
+    else {
+        return false;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        int bits = key->prefix - (int) (i * 8);
+
+        if (bits <= 0) {
+            key->address[i] = 0;
+        }
+        else if (bits < 8) {
+            key->address[i] &= 0xFF << (8 - bits);
+        }
+    }
+
+    return true;
+}
+
+static
+CDAdmissionEntry*
+cd_AdmissionEntry (CDAdmission* self, CDAdmissionKey key, int burst, uint64_t now)
+{
+    khiter_t          it = kh_get(cdAdmission, self->raw, key);
+    CDAdmissionEntry* entry;
+    int               ret;
+
+    if (it != kh_end(self->raw)) {
+        return kh_value(self->raw, it);
+    }
+
+    if (kh_size(self->raw) >= CD_ADMISSION_MAX_ENTRIES) {
+        return NULL;
+    }
+
+    entry            = CD_malloc(sizeof(CDAdmissionEntry));
+    entry->connected = 0;
+    entry->tokens    = burst;
+    entry->updated   = now;
+
+    it = kh_put(cdAdmission, self->raw, key, &ret);
+    kh_value(self->raw, it) = entry;
+
+    return entry;
+}
+
+static
+void
+cd_AdmissionRefill (CDAdmissionEntry* entry, float rate, int burst, uint64_t now)
+{
+    entry->tokens  += rate * ((now - entry->updated) / 1000000000.0);
+    entry->updated  = now;
+
+    if (entry->tokens > burst) {
+        entry->tokens = burst;
+    }
+}
+
+static
+bool
+cd_AdmissionIdle (CDAdmissionEntry* entry, float rate, int burst, uint64_t now)
+{
+    // Without a rate the bucket isn't used, nothing is lost dropping the entry
+    if (rate <= 0) {
+        return true;
+    }
+
+    cd_AdmissionRefill(entry, rate, burst, now);
+
+    return entry->tokens >= burst;
+}
+
+static
+size_t
+cd_AdmissionSweep (CDAdmission* self, uint64_t now)
+{
+    CDConfig* config = self->server->config;
+    size_t    freed  = 0;
+
+    self->swept = now;
+
+    for (khiter_t it = kh_begin(self->raw); it != kh_end(self->raw); it++) {
+        if (!kh_exist(self->raw, it)) {
+            continue;
+        }
+
+        CDAdmissionEntry* entry = kh_value(self->raw, it);
+
+        if (entry->connected > 0) {
+            continue;
+        }
+
+        if (kh_key(self->raw, it).network) {
+            if (!cd_AdmissionIdle(entry, config->cache.connection.throttle.network.rate, config->cache.connection.throttle.network.burst, now)) {
+                continue;
+            }
+        }
+        else {
+            if (!cd_AdmissionIdle(entry, config->cache.connection.throttle.address.rate, config->cache.connection.throttle.address.burst, now)) {
+                continue;
+            }
+        }
+
+        CD_free(entry);
+        kh_del(cdAdmission, self->raw, it);
+
+        freed++;
+    }
+
+    return freed;
+}
+
+CDAdmission*
+CD_CreateAdmission (CDServer* server)
+{
+    CDAdmission* self = CD_malloc(sizeof(CDAdmission));
+
+    if (pthread_mutex_init(&self->lock, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    self->server = server;
+    self->raw    = kh_init(cdAdmission);
+    self->swept  = 0;
+
+    assert(self->raw);
+
+    return self;
+}
+
+void
+CD_DestroyAdmission (CDAdmission* self)
+{
+    assert(self);
+
+    for (khiter_t it = kh_begin(self->raw); it != kh_end(self->raw); it++) {
+        if (kh_exist(self->raw, it)) {
+            CD_free(kh_value(self->raw, it));
+        }
+    }
+
+    kh_destroy(cdAdmission, self->raw);
+
+    pthread_mutex_destroy(&self->lock);
+
+    CD_free(self);
+}
+
+bool
+CD_AdmissionAdmit (CDAdmission* self, struct sockaddr* address)
+{
+    CDConfig*         config = self->server->config;
+    uint64_t          now    = CD_MonotonicTime();
+    CDAdmissionKey    key;
+    CDAdmissionEntry* single;
+    CDAdmissionEntry* network;
+    bool              result = true;
+
+    assert(self);
+    assert(address);
+
+    if (!cd_AdmissionKey(address, false, 0, 0, &key)) {
+        errno = EAFNOSUPPORT;
+
+        return false;
+    }
+
+    pthread_mutex_lock(&self->lock);
+
+    // When a sweep frees nothing the table stays full until the next one, new addresses are refused until then
+    if (kh_size(self->raw) >= CD_ADMISSION_MAX_ENTRIES && now - self->swept >= CD_ADMISSION_SWEEP_BACKOFF) {
+        cd_AdmissionSweep(self, now);
+    }
+
+    single = cd_AdmissionEntry(self, key, config->cache.connection.throttle.address.burst, now);
+
+    cd_AdmissionKey(address, true, config->cache.connection.throttle.network.ipv4, config->cache.connection.throttle.network.ipv6, &key);
+
+    network = cd_AdmissionEntry(self, key, config->cache.connection.throttle.network.burst, now);
+
+    if (!single || !network) {
+        pthread_mutex_unlock(&self->lock);
+
+        errno = EAGAIN;
+
+        return false;
+    }
+
+    cd_AdmissionRefill(single, config->cache.connection.throttle.address.rate, config->cache.connection.throttle.address.burst, now);
+    cd_AdmissionRefill(network, config->cache.connection.throttle.network.rate, config->cache.connection.throttle.network.burst, now);
+
+    if (config->cache.game.clients.simultaneous > 0 && single->connected >= config->cache.game.clients.simultaneous) {
+        errno  = EMFILE;
+        result = false;
+    }
+    else if ((config->cache.connection.throttle.address.rate > 0 && single->tokens < 1) ||
+             (config->cache.connection.throttle.network.rate > 0 && network->tokens < 1)) {
+        errno  = EAGAIN;
+        result = false;
+    }
+    else {
+        if (config->cache.connection.throttle.address.rate > 0) {
+            single->tokens--;
+        }
+
+        if (config->cache.connection.throttle.network.rate > 0) {
+            network->tokens--;
+        }
+
+        single->connected++;
+        network->connected++;
+    }
+
+    pthread_mutex_unlock(&self->lock);
+
+    return result;
+}
+
+void
+CD_AdmissionRelease (CDAdmission* self, struct sockaddr* address)
+{
+    CDConfig*      config = self->server->config;
+    CDAdmissionKey key;
+    khiter_t       it;
+
+    assert(self);
+    assert(address);
+
+    pthread_mutex_lock(&self->lock);
+
+    if (cd_AdmissionKey(address, false, 0, 0, &key)) {
+        if ((it = kh_get(cdAdmission, self->raw, key)) != kh_end(self->raw)) {
+            kh_value(self->raw, it)->connected--;
+        }
+
+        cd_AdmissionKey(address, true, config->cache.connection.throttle.network.ipv4, config->cache.connection.throttle.network.ipv6, &key);
+
+        if ((it = kh_get(cdAdmission, self->raw, key)) != kh_end(self->raw)) {
+            kh_value(self->raw, it)->connected--;
+        }
+    }
+
+    pthread_mutex_unlock(&self->lock);
+}
+
+void
+CD_AdmissionSweep (CDAdmission* self)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock);
+    cd_AdmissionSweep(self, CD_MonotonicTime());
+    pthread_mutex_unlock(&self->lock);
+}
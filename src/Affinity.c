@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Affinity.h>
+#include <craftd/Server.h>
+#include <craftd/Logger.h>
+
+#include <sched.h>
+#include <dirent.h>
+
+static
+size_t
+cd_AffinityParse (const char* list, int* cpus, size_t length)
+{
+    size_t      result = 0;
+    const char* current = list;
+
+    while (*current) {
+        char* end;
+        long  first = strtol(current, &end, 10);
+        long  last  = first;
+
+        if (end == current || first < 0) {
+            errno = EINVAL;
+            return 0;
+        }
+
+        if (*end == '-') {
+            current = end + 1;
+            last    = strtol(current, &end, 10);
+
+            if (end == current || last < first) {
+                errno = EINVAL;
+                return 0;
+            }
+        }
+
+        // A cpu_set_t can't hold them, CPU_SET would write past it
+        if (last >= CPU_SETSIZE) {
+            errno = ERANGE;
+            return 0;
+        }
+
+        for (long cpu = first; cpu <= last && result < length; cpu++) {
+            cpus[result++] = cpu;
+        }
+
+        while (*end == ',' || *end == ' ') {
+            end++;
+        }
+
+        current = end;
+    }
+
+    return result;
+}
+
+bool
+CD_AffinityPin (CDServer* server, const char* name, const char* list, int index)
+{
+    if (!list || !*list) {
+        return false;
+    }
+
+    #ifdef HAVE_PTHREAD_SETAFFINITY_NP
+    int       cpus[CPU_SETSIZE];
+    size_t    length = cd_AffinityParse(list, cpus, CPU_SETSIZE);
+    cpu_set_t set;
+
+    if (length == 0) {
+        if (errno == ERANGE) {
+            SERR(server, "invalid CPU list for %s: %s, CPU ids have to be lower than %d", name, list, CPU_SETSIZE);
+        }
+        else {
+            SERR(server, "invalid CPU list for %s: %s", name, list);
+        }
+
+        return false;
+    }
+
+    CPU_ZERO(&set);
+
+    if (index >= 0) {
+        CPU_SET(cpus[index % length], &set);
+    }
+    else {
+        for (size_t i = 0; i < length; i++) {
+            CPU_SET(cpus[i], &set);
+        }
+    }
+
+    if ((errno = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set)) != 0) {
+        SERR(server, "could not pin %s to CPUs %s: %s", name, list, strerror(errno));
+
+        return false;
+    }
+
+    if (index >= 0) {
+        SLOG(server, LOG_INFO, "%s pinned to CPU %d", name, cpus[index % length]);
+    }
+    else {
+        SLOG(server, LOG_INFO, "%s pinned to CPUs %s", name, list);
+    }
+
+    return true;
+    #else
+    SERR(server, "CPU affinity is not supported on this system, %s is not pinned", name);
+
+    return false;
+    #endif
+}
+
+void
+CD_AffinityLogTopology (CDServer* server)
+{
+    DIR*           nodes = opendir("/sys/devices/system/node");
+    struct dirent* entry;
+    int            found = 0;
+
+    if (nodes) {
+        while ((entry = readdir(nodes))) {
+            char  path[PATH_MAX];
+            char  cpus[256];
+            int   node;
+            FILE* file;
+
+            if (sscanf(entry->d_name, "node%d", &node) != 1) {
+                continue;
+            }
+
+            snprintf(path, sizeof(path), "/sys/devices/system/node/%s/cpulist", entry->d_name);
+
+            if (!(file = fopen(path, "r"))) {
+                continue;
+            }
+
+            if (fgets(cpus, sizeof(cpus), file)) {
+                cpus[strcspn(cpus, "\n")] = '\0';
+
+                SLOG(server, LOG_INFO, "NUMA node %d has CPUs %s", node, cpus);
+
+                found++;
+            }
+
+            fclose(file);
+        }
+
+        closedir(nodes);
+    }
+
+    if (!found) {
+        SLOG(server, LOG_INFO, "no NUMA topology available");
+    }
+
+    SLOG(server, LOG_INFO, "affinity: workers %s, reactors %s, timeloop %s, httpd %s",
+        server->config->cache.affinity.workers  ? server->config->cache.affinity.workers  : "any",
+        server->config->cache.affinity.reactors ? server->config->cache.affinity.reactors : "any",
+        server->config->cache.affinity.timeloop ? server->config->cache.affinity.timeloop : "any",
+        server->config->cache.affinity.httpd    ? server->config->cache.affinity.httpd    : "any");
+}
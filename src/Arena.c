@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Arena.h>
+
+// Alignment of every allocation, enough for any scalar
+#define CD_ARENA_ALIGN 16
+
+static __thread CDArena cd_Arena = { NULL, NULL, NULL };
+
+static
+void
+cd_ArenaDrop (CDArenaBlock* block)
+{
+    // One block of the default size is kept around so a Job doesn't have to allocate it again
+    if (block->size == CD_ARENA_BLOCK && !cd_Arena.spare) {
+        cd_Arena.spare = block;
+    }
+    else {
+        CD_free(block);
+    }
+}
+
+static
+void
+cd_ArenaGrow (size_t size)
+{
+    CDArenaBlock* block;
+    size_t        needed = size + CD_ARENA_ALIGN;
+
+    if (needed <= CD_ARENA_BLOCK && cd_Arena.spare) {
+        block          = cd_Arena.spare;
+        cd_Arena.spare = NULL;
+    }
+    else {
+        size_t capacity = (needed > CD_ARENA_BLOCK) ? needed : CD_ARENA_BLOCK;
+
+        block       = CD_malloc(sizeof(CDArenaBlock) + capacity);
+        block->size = capacity;
+    }
+
+    block->length    = 0;
+    block->next      = cd_Arena.current;
+    cd_Arena.current = block;
+}
+
+void*
+CD_ArenaAlloc (size_t size)
+{
+    CDArenaBlock* block = cd_Arena.current;
+
+    while (true) {
+        if (block) {
+            size_t padding = (size_t) -(uintptr_t) (block->data + block->length) & (CD_ARENA_ALIGN - 1);
+
+            if (block->size - block->length >= padding + size) {
+                void* result = block->data + block->length + padding;
+
+                block->length += padding + size;
+
+                return result;
+            }
+        }
+
+        cd_ArenaGrow(size);
+
+        block = cd_Arena.current;
+    }
+}
+
+char*
+CD_ArenaFormat (size_t* length, const char* format, ...)
+{
+    va_list ap;
+    char*   result;
+    int     size;
+
+    va_start(ap, format);
+    size = vsnprintf(NULL, 0, format, ap);
+    va_end(ap);
+
+    if (size < 0) {
+        size = 0;
+    }
+
+    result = CD_ArenaAlloc(size + 1);
+
+    va_start(ap, format);
+    vsnprintf(result, size + 1, format, ap);
+    va_end(ap);
+
+    if (length) {
+        *length = size;
+    }
+
+    return result;
+}
+
+CDArenaMark
+CD_ArenaSave (void)
+{
+    CDArenaMark mark = { cd_Arena.current, cd_Arena.current ? cd_Arena.current->length : 0 };
+
+    return mark;
+}
+
+void
+CD_ArenaRestore (CDArenaMark mark)
+{
+    while (cd_Arena.current != mark.block) {
+        CDArenaBlock* block = cd_Arena.current;
+
+        assert(block);
+
+        cd_Arena.current = block->next;
+
+        cd_ArenaDrop(block);
+    }
+
+    if (cd_Arena.current) {
+        cd_Arena.current->length = mark.length;
+    }
+}
+
+void
+CD_ArenaReset (void)
+{
+    CDArenaMark empty = { NULL, 0 };
+
+    CD_ArenaRestore(empty);
+
+    if (cd_Arena.buffer && !CD_BufferEmpty(cd_Arena.buffer)) {
+        CD_BufferDrain(cd_Arena.buffer, CD_BufferLength(cd_Arena.buffer));
+    }
+}
+
+CDBuffer*
+CD_ArenaBuffer (void)
+{
+    if (!cd_Arena.buffer) {
+        cd_Arena.buffer = CD_CreateBuffer();
+    }
+    else if (!CD_BufferEmpty(cd_Arena.buffer)) {
+        CD_BufferDrain(cd_Arena.buffer, CD_BufferLength(cd_Arena.buffer));
+    }
+
+    return cd_Arena.buffer;
+}
+
+void
+CD_ArenaFlush (void)
+{
+    CDArenaMark empty = { NULL, 0 };
+
+    CD_ArenaRestore(empty);
+
+    if (cd_Arena.spare) {
+        CD_free(cd_Arena.spare);
+
+        cd_Arena.spare = NULL;
+    }
+
+    if (cd_Arena.buffer) {
+        CD_DestroyBuffer(cd_Arena.buffer);
+
+        cd_Arena.buffer = NULL;
+    }
+}
@@ -98,11 +98,9 @@ CD_BufferAdd (CDBuffer* self, CDPointer data, size_t length)
 void
 CD_BufferAddBuffer (CDBuffer* self, CDBuffer* data)
 {
-    CDPointer stuff = CD_BufferContent(data);
+    size_t length = CD_BufferLength(data);
 
-    evbuffer_add(self->raw, (void*) stuff, CD_BufferLength(data));
-
-    CD_free((void*) stuff);
+    evbuffer_add(self->raw, evbuffer_pullup(data->raw, length), length);
 }
 
 CDPointer
@@ -129,3 +127,54 @@ CD_BufferRemoveBuffer (CDBuffer* self)
 
     return result;
 }
+
+static
+void
+cd_SharedBufferCleanup (const void* data, size_t length, CDSharedBuffer* self)
+{
+    CD_SharedBufferRelease(self);
+}
+
+void
+CD_BufferAddSharedBuffer (CDBuffer* self, CDSharedBuffer* data)
+{
+    assert(self);
+    assert(data);
+
+    evbuffer_add_reference(self->raw, data->data, data->length,
+        (evbuffer_ref_cleanup_cb) cd_SharedBufferCleanup, CD_SharedBufferRetain(data));
+}
+
+CDSharedBuffer*
+CD_CreateSharedBuffer (CDBuffer* buffer)
+{
+    size_t          length = CD_BufferLength(buffer);
+    CDSharedBuffer* self   = CD_malloc(sizeof(CDSharedBuffer) + length);
+
+    self->references = 1;
+    self->length     = length;
+
+    evbuffer_copyout(buffer->raw, self->data, length);
+
+    return self;
+}
+
+CDSharedBuffer*
+CD_SharedBufferRetain (CDSharedBuffer* self)
+{
+    assert(self);
+
+    __sync_add_and_fetch(&self->references, 1);
+
+    return self;
+}
+
+void
+CD_SharedBufferRelease (CDSharedBuffer* self)
+{
+    assert(self);
+
+    if (__sync_sub_and_fetch(&self->references, 1) == 0) {
+        CD_free(self);
+    }
+}
@@ -26,6 +26,50 @@
 #include <craftd/Client.h>
 #include <craftd/Server.h>
 
+static
+void
+cd_ClientFlush (CDClient* self)
+{
+    if (!self->output.pending || !self->buffers) {
+        return;
+    }
+
+    evtimer_del(self->output.timer);
+
+    if (!CD_BufferEmpty(self->output.pending)) {
+        evbuffer_add_buffer(self->buffers->output->raw, self->output.pending->raw);
+    }
+}
+
+static
+void
+cd_ClientSchedule (CDClient* self)
+{
+    int delay = self->server->config->cache.connection.output.delay;
+
+    if (CD_BufferLength(self->output.pending) >= self->server->config->cache.connection.output.bytes) {
+        cd_ClientFlush(self);
+    }
+    else if (self->output.corked > 0) {
+        return;
+    }
+    else if (delay <= 0) {
+        cd_ClientFlush(self);
+    }
+    else if (!evtimer_pending(self->output.timer, NULL)) {
+        struct timeval timeout = { delay / 1000, (delay % 1000) * 1000 };
+
+        evtimer_add(self->output.timer, &timeout);
+    }
+}
+
+static
+void
+cd_ClientFlushTimeout (evutil_socket_t fd, short event, CDClient* self)
+{
+    CD_ClientFlush(self);
+}
+
 CDClient*
 CD_CreateClient (CDServer* server)
 {
@@ -35,12 +79,24 @@ CD_CreateClient (CDServer* server)
         CD_abort("pthread rwlock failed to initialize");
     }
 
-    self->server = server;
+    if (pthread_mutex_init(&self->lock.output, NULL) != 0) {
+        CD_abort("pthread mutex failed to initialize");
+    }
+
+    self->server  = server;
+    self->reactor = NULL;
 
-    self->status = CDClientConnect;
-    self->jobs   = 0;
+    self->status     = CDClientConnect;
+    self->references = 1;
 
     self->buffers = NULL;
+    self->lane    = CD_CreateLane();
+
+    self->output.pending = NULL;
+    self->output.timer   = NULL;
+    self->output.corked  = 0;
+
+    self->address.ss_family = AF_UNSPEC;
 
     DYNAMIC(self) = CD_CreateDynamic();
     ERROR(self)   = CDNull;
@@ -55,6 +111,18 @@ CD_DestroyClient (CDClient* self)
 
     CD_EventDispatch(self->server, "Client.destroy", self);
 
+    if (self->output.timer) {
+        event_free(self->output.timer);
+    }
+
+    if (self->output.pending) {
+        if (self->buffers) {
+            evbuffer_add_buffer(self->buffers->output->raw, self->output.pending->raw);
+        }
+
+        CD_DestroyBuffer(self->output.pending);
+    }
+
     if (self->buffers) {
         bufferevent_flush(self->buffers->raw, EV_READ | EV_WRITE, BEV_FINISHED);
         bufferevent_disable(self->buffers->raw, EV_READ | EV_WRITE);
@@ -63,13 +131,97 @@ CD_DestroyClient (CDClient* self)
         CD_DestroyBuffers(self->buffers);
     }
 
+    if (self->address.ss_family != AF_UNSPEC) {
+        CD_AdmissionRelease(self->server->admission, (struct sockaddr*) &self->address);
+    }
+
+    CD_DestroyLane(self->lane);
+
     CD_DestroyDynamic(DYNAMIC(self));
 
     pthread_rwlock_destroy(&self->lock.status);
+    pthread_mutex_destroy(&self->lock.output);
 
     CD_free(self);
 }
 
+static
+void
+cd_DestroyClientCallback (evutil_socket_t fd, short event, CDClient* self)
+{
+    CD_DestroyClient(self);
+}
+
+void
+CD_DestroyClientDeferred (CDClient* self)
+{
+    struct timeval now = { 0, 0 };
+
+    assert(self);
+
+    if (!self->reactor || event_base_once(self->reactor->event.base, -1, EV_TIMEOUT,
+            (event_callback_fn) cd_DestroyClientCallback, self, &now) < 0) {
+        CD_DestroyClient(self);
+    }
+}
+
+CDClient*
+CD_ClientRetain (CDClient* self)
+{
+    assert(self);
+
+    int references = __sync_fetch_and_add(&self->references, 1);
+
+    assert(references > 0);
+
+    (void) references;
+
+    return self;
+}
+
+CDClient*
+CD_ClientTryRetain (CDClient* self)
+{
+    assert(self);
+
+    int references = __atomic_load_n(&self->references, __ATOMIC_ACQUIRE);
+
+    do {
+        // The last reference is gone, the Client is already on its way to be destroyed
+        if (references == 0) {
+            return NULL;
+        }
+    } while (!__atomic_compare_exchange_n(&self->references, &references, references + 1, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    return self;
+}
+
+void
+CD_ClientRelease (CDClient* self)
+{
+    assert(self);
+
+    if (__sync_sub_and_fetch(&self->references, 1) == 0) {
+        CD_AddJob(self->server->workers, CD_CreateExternalJob(CDClientDisconnectJob, (CDPointer) self));
+    }
+}
+
+void
+CD_ClientAddJob (CDClient* self, CDJob* job)
+{
+    assert(self);
+    assert(job);
+
+    // The wait of the Job counts from here, the time on the Lane included
+    job->queued = CD_MonotonicTime();
+
+    // The Lane Job holds a reference until the Lane is drained
+    if (CD_LanePush(self->lane, (CDPointer) job)) {
+        CD_AddJobWithPriority(self->server->workers, CD_CreateExternalJob(CDClientLaneJob, (CDPointer) CD_ClientRetain(self)),
+            job->priority);
+    }
+}
+
 void
 CD_ClientSendBuffer (CDClient* self, CDBuffer* buffer)
 {
@@ -80,7 +232,85 @@ CD_ClientSendBuffer (CDClient* self, CDBuffer* buffer)
         return;
     }
 
-    CD_BufferAddBuffer(self->buffers->output, buffer);
+    if (!self->output.pending) {
+        CD_BufferAddBuffer(self->buffers->output, buffer);
+
+        CD_BuffersFlush(self->buffers);
+
+        return;
+    }
+
+    pthread_mutex_lock(&self->lock.output);
+    CD_BufferAddBuffer(self->output.pending, buffer);
+    cd_ClientSchedule(self);
+    pthread_mutex_unlock(&self->lock.output);
+}
+
+void
+CD_ClientSendSharedBuffer (CDClient* self, CDSharedBuffer* buffer)
+{
+    assert(self);
+    assert(buffer);
+
+    if (!self->buffers) {
+        return;
+    }
+
+    if (!self->output.pending) {
+        CD_BufferAddSharedBuffer(self->buffers->output, buffer);
+
+        CD_BuffersFlush(self->buffers);
+
+        return;
+    }
+
+    pthread_mutex_lock(&self->lock.output);
+    CD_BufferAddSharedBuffer(self->output.pending, buffer);
+    cd_ClientSchedule(self);
+    pthread_mutex_unlock(&self->lock.output);
+}
+
+void
+CD_ClientCoalesceOutput (CDClient* self, struct event_base* base)
+{
+    assert(self);
+
+    if (self->output.pending) {
+        return;
+    }
+
+    self->output.pending = CD_CreateBuffer();
+    self->output.timer   = evtimer_new(base, (event_callback_fn) cd_ClientFlushTimeout, self);
+}
+
+void
+CD_ClientCork (CDClient* self)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.output);
+    self->output.corked++;
+    pthread_mutex_unlock(&self->lock.output);
+}
+
+void
+CD_ClientUncork (CDClient* self)
+{
+    assert(self);
+
+    pthread_mutex_lock(&self->lock.output);
+    if (--self->output.corked == 0) {
+        cd_ClientFlush(self);
+    }
+    pthread_mutex_unlock(&self->lock.output);
+}
+
+void
+CD_ClientFlush (CDClient* self)
+{
+    assert(self);
 
-    CD_BuffersFlush(self->buffers);
+    pthread_mutex_lock(&self->lock.output);
+    cd_ClientFlush(self);
+    pthread_mutex_unlock(&self->lock.output);
 }
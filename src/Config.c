@@ -44,7 +44,19 @@ CD_ParseConfig (const char* path)
     self->cache.daemonize = true;
 
     self->cache.connection.port    = 25565;
-    self->cache.connection.backlog = 16;
+    self->cache.connection.backlog  = 16;
+    self->cache.connection.reactors = 1;
+
+    self->cache.connection.throttle.address.rate  = 2;
+    self->cache.connection.throttle.address.burst = 10;
+    self->cache.connection.throttle.network.rate  = 20;
+    self->cache.connection.throttle.network.burst = 50;
+    self->cache.connection.throttle.network.ipv4  = 24;
+    self->cache.connection.throttle.network.ipv6  = 64;
+
+    self->cache.connection.output.coalesce = true;
+    self->cache.connection.output.delay    = 5;
+    self->cache.connection.output.bytes    = 16384;
 
     self->cache.connection.bind.ipv4.sin_family      = AF_INET;
     self->cache.connection.bind.ipv4.sin_addr.s_addr = INADDR_ANY;
@@ -58,6 +70,36 @@ CD_ParseConfig (const char* path)
 
     self->cache.workers = 2;
 
+    self->cache.affinity.workers  = NULL;
+    self->cache.affinity.reactors = NULL;
+    self->cache.affinity.timeloop = NULL;
+    self->cache.affinity.httpd    = NULL;
+
+    self->cache.autoscale.enabled  = false;
+    self->cache.autoscale.min      = 2;
+    self->cache.autoscale.max      = 16;
+    self->cache.autoscale.interval = 5;
+    self->cache.autoscale.wait     = 50;
+    self->cache.autoscale.high     = 0.85;
+    self->cache.autoscale.low      = 0.30;
+    self->cache.autoscale.samples  = 3;
+
+    self->cache.stats.interval = 0;
+    self->cache.stats.events   = false;
+
+    self->cache.memory.allocator = NULL;
+
+    self->cache.scheduler.capacity = 65536;
+    self->cache.scheduler.stealing = false;
+
+    self->cache.scheduler.weights[0] = 8;
+    self->cache.scheduler.weights[1] = 4;
+    self->cache.scheduler.weights[2] = 1;
+
+    self->cache.scheduler.lane.batch   = 16;
+    self->cache.scheduler.lane.depth   = 64;
+    self->cache.scheduler.lane.packets = 32;
+
     self->cache.game.protocol.standard    = true;
     self->cache.game.clients.max          = 0;
     self->cache.game.clients.simultaneous = 3;
@@ -67,13 +109,146 @@ CD_ParseConfig (const char* path)
 
         C_SAVE(C_GET(server, "workers"), C_INT, self->cache.workers);
 
+        C_IN(affinity, server, "affinity") {
+            C_SAVE(C_GET(affinity, "workers"),  C_STRING, self->cache.affinity.workers);
+            C_SAVE(C_GET(affinity, "reactors"), C_STRING, self->cache.affinity.reactors);
+            C_SAVE(C_GET(affinity, "timeloop"), C_STRING, self->cache.affinity.timeloop);
+            C_SAVE(C_GET(affinity, "httpd"),    C_STRING, self->cache.affinity.httpd);
+        }
+
+        C_IN(autoscale, server, "autoscale") {
+            C_SAVE(C_GET(autoscale, "enabled"),  C_BOOL,  self->cache.autoscale.enabled);
+            C_SAVE(C_GET(autoscale, "min"),      C_INT,   self->cache.autoscale.min);
+            C_SAVE(C_GET(autoscale, "max"),      C_INT,   self->cache.autoscale.max);
+            C_SAVE(C_GET(autoscale, "interval"), C_FLOAT, self->cache.autoscale.interval);
+            C_SAVE(C_GET(autoscale, "wait"),     C_FLOAT, self->cache.autoscale.wait);
+            C_SAVE(C_GET(autoscale, "high"),     C_FLOAT, self->cache.autoscale.high);
+            C_SAVE(C_GET(autoscale, "low"),      C_FLOAT, self->cache.autoscale.low);
+            C_SAVE(C_GET(autoscale, "samples"),  C_INT,   self->cache.autoscale.samples);
+
+            if (self->cache.autoscale.min < 1) {
+                self->cache.autoscale.min = 1;
+            }
+
+            if (self->cache.autoscale.max < self->cache.autoscale.min) {
+                self->cache.autoscale.max = self->cache.autoscale.min;
+            }
+
+            if (self->cache.autoscale.samples < 1) {
+                self->cache.autoscale.samples = 1;
+            }
+        }
+
+        C_IN(stats, server, "stats") {
+            C_SAVE(C_GET(stats, "interval"), C_FLOAT, self->cache.stats.interval);
+            C_SAVE(C_GET(stats, "events"),   C_BOOL,  self->cache.stats.events);
+        }
+
+        C_IN(memory, server, "memory") {
+            C_SAVE(C_GET(memory, "allocator"), C_STRING, self->cache.memory.allocator);
+
+            if (self->cache.memory.allocator && !CD_UseAllocator(self->cache.memory.allocator)) {
+                ERR("unknown or unavailable allocator %s, keeping %s", self->cache.memory.allocator, CD_Allocator->name);
+            }
+        }
+
+        C_IN(scheduler, server, "scheduler") {
+            C_SAVE(C_GET(scheduler, "capacity"), C_INT, self->cache.scheduler.capacity);
+
+            // The Queues round it up to a power of 2
+            if (self->cache.scheduler.capacity < 2) {
+                self->cache.scheduler.capacity = 2;
+            }
+            else if (self->cache.scheduler.capacity > (1 << 24)) {
+                self->cache.scheduler.capacity = 1 << 24;
+            }
+
+            DO {
+                const char* mode = NULL;
+
+                C_SAVE(C_GET(scheduler, "mode"), C_STRING, mode);
+
+                if (mode) {
+                    if (CD_CStringIsEqual(mode, "stealing")) {
+                        self->cache.scheduler.stealing = true;
+                    }
+                    else if (!CD_CStringIsEqual(mode, "queue")) {
+                        ERR("unknown scheduler mode %s, falling back to queue", mode);
+                    }
+                }
+            }
+
+            C_IN(weights, scheduler, "weights") {
+                C_SAVE(C_GET(weights, "high"),   C_INT, self->cache.scheduler.weights[0]);
+                C_SAVE(C_GET(weights, "normal"), C_INT, self->cache.scheduler.weights[1]);
+                C_SAVE(C_GET(weights, "bulk"),   C_INT, self->cache.scheduler.weights[2]);
+
+                for (int i = 0; i < 3; i++) {
+                    if (self->cache.scheduler.weights[i] < 0) {
+                        self->cache.scheduler.weights[i] = 0;
+                    }
+                }
+
+                if (self->cache.scheduler.weights[0] + self->cache.scheduler.weights[1] + self->cache.scheduler.weights[2] == 0) {
+                    self->cache.scheduler.weights[0] = 1;
+                }
+            }
+
+            C_IN(lane, scheduler, "lane") {
+                C_SAVE(C_GET(lane, "batch"),   C_INT, self->cache.scheduler.lane.batch);
+                C_SAVE(C_GET(lane, "depth"),   C_INT, self->cache.scheduler.lane.depth);
+                C_SAVE(C_GET(lane, "packets"), C_INT, self->cache.scheduler.lane.packets);
+
+                if (self->cache.scheduler.lane.batch < 1) {
+                    self->cache.scheduler.lane.batch = 1;
+                }
+
+                if (self->cache.scheduler.lane.depth < 1) {
+                    self->cache.scheduler.lane.depth = 1;
+                }
+
+                // The packets are parsed on the stack of the reactor
+                if (self->cache.scheduler.lane.packets < 1) {
+                    self->cache.scheduler.lane.packets = 1;
+                }
+                else if (self->cache.scheduler.lane.packets > 1024) {
+                    self->cache.scheduler.lane.packets = 1024;
+                }
+            }
+        }
+
         C_IN(connection, server, "connection") {
-            C_SAVE(C_GET(connection, "port"),    C_INT, self->cache.connection.port);
-            C_SAVE(C_GET(connection, "backlog"), C_INT, self->cache.connection.backlog);
+            C_SAVE(C_GET(connection, "port"),     C_INT, self->cache.connection.port);
+            C_SAVE(C_GET(connection, "backlog"),  C_INT, self->cache.connection.backlog);
+            C_SAVE(C_GET(connection, "reactors"), C_INT, self->cache.connection.reactors);
+
+            if (self->cache.connection.reactors < 1) {
+                self->cache.connection.reactors = 1;
+            }
 
             self->cache.connection.bind.ipv4.sin_port  = htons(self->cache.connection.port);
             self->cache.connection.bind.ipv6.sin6_port = htons(self->cache.connection.port);
 
+            C_IN(throttle, connection, "throttle") {
+                C_IN(address, throttle, "address") {
+                    C_SAVE(C_GET(address, "rate"),  C_FLOAT, self->cache.connection.throttle.address.rate);
+                    C_SAVE(C_GET(address, "burst"), C_INT,   self->cache.connection.throttle.address.burst);
+                }
+
+                C_IN(network, throttle, "network") {
+                    C_SAVE(C_GET(network, "rate"),  C_FLOAT, self->cache.connection.throttle.network.rate);
+                    C_SAVE(C_GET(network, "burst"), C_INT,   self->cache.connection.throttle.network.burst);
+                    C_SAVE(C_GET(network, "ipv4"),  C_INT,   self->cache.connection.throttle.network.ipv4);
+                    C_SAVE(C_GET(network, "ipv6"),  C_INT,   self->cache.connection.throttle.network.ipv6);
+                }
+            }
+
+            C_IN(output, connection, "output") {
+                C_SAVE(C_GET(output, "coalesce"), C_BOOL, self->cache.connection.output.coalesce);
+                C_SAVE(C_GET(output, "delay"),    C_INT,  self->cache.connection.output.delay);
+                C_SAVE(C_GET(output, "bytes"),    C_INT,  self->cache.connection.output.bytes);
+            }
+
             C_IN(bind, connection, "bind") {
                 if (C_GET(bind, "ipv4")) {
                     if (evutil_inet_pton(AF_INET, C_TO_STRING(C_GET(bind, "ipv4")), &self->cache.connection.bind.ipv4.sin_addr) != 1) {
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Deque.h>
+
+static
+CDDequeArray*
+cd_CreateDequeArray (size_t size)
+{
+    CDDequeArray* self = CD_malloc(sizeof(CDDequeArray) + sizeof(CDPointer) * size);
+
+    self->mask = size - 1;
+
+    return self;
+}
+
+CDDeque*
+CD_CreateDeque (size_t capacity)
+{
+    CDDeque* self = CD_malloc(sizeof(CDDeque));
+    size_t   size = 2;
+
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    self->array   = cd_CreateDequeArray(size);
+    self->retired = CD_CreateList();
+    self->top     = 0;
+    self->bottom  = 0;
+
+    return self;
+}
+
+void
+CD_DestroyDeque (CDDeque* self)
+{
+    assert(self);
+
+    CD_LIST_FOREACH(self->retired, it) {
+        CD_free((void*) CD_ListIteratorValue(it));
+    }
+
+    CD_DestroyList(self->retired);
+
+    CD_free(self->array);
+    CD_free(self);
+}
+
+size_t
+CD_DequeLength (CDDeque* self)
+{
+    assert(self);
+
+    int64_t bottom = __atomic_load_n(&self->bottom, __ATOMIC_ACQUIRE);
+    int64_t top    = __atomic_load_n(&self->top, __ATOMIC_ACQUIRE);
+
+    return (bottom > top) ? bottom - top : 0;
+}
+
+void
+CD_DequePush (CDDeque* self, CDPointer data)
+{
+    assert(self);
+    assert(data);
+
+    int64_t       bottom = __atomic_load_n(&self->bottom, __ATOMIC_RELAXED);
+    int64_t       top    = __atomic_load_n(&self->top, __ATOMIC_ACQUIRE);
+    CDDequeArray* array  = __atomic_load_n(&self->array, __ATOMIC_RELAXED);
+
+    if (bottom - top > (int64_t) array->mask) {
+        CDDequeArray* grown = cd_CreateDequeArray((array->mask + 1) * 2);
+
+        for (int64_t i = top; i < bottom; i++) {
+            grown->item[i & grown->mask] = array->item[i & array->mask];
+        }
+
+        // Thieves might still be reading the old array, it goes away with the Deque
+        CD_ListPush(self->retired, (CDPointer) array);
+
+        __atomic_store_n(&self->array, grown, __ATOMIC_RELEASE);
+
+        array = grown;
+    }
+
+    __atomic_store_n(&array->item[bottom & array->mask], data, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&self->bottom, bottom + 1, __ATOMIC_RELAXED);
+}
+
+CDPointer
+CD_DequePop (CDDeque* self)
+{
+    assert(self);
+
+    int64_t       bottom = __atomic_load_n(&self->bottom, __ATOMIC_RELAXED) - 1;
+    CDDequeArray* array  = __atomic_load_n(&self->array, __ATOMIC_RELAXED);
+    int64_t       top;
+    CDPointer     result = CDNull;
+
+    __atomic_store_n(&self->bottom, bottom, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    top = __atomic_load_n(&self->top, __ATOMIC_RELAXED);
+
+    if (top <= bottom) {
+        result = __atomic_load_n(&array->item[bottom & array->mask], __ATOMIC_RELAXED);
+
+        if (top == bottom) {
+            // Last element, race against the thieves for it
+            if (!__atomic_compare_exchange_n(&self->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                result = CDNull;
+            }
+
+            __atomic_store_n(&self->bottom, bottom + 1, __ATOMIC_RELAXED);
+        }
+    }
+    else {
+        __atomic_store_n(&self->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+
+    return result;
+}
+
+CDPointer
+CD_DequeSteal (CDDeque* self)
+{
+    assert(self);
+
+    int64_t   top = __atomic_load_n(&self->top, __ATOMIC_ACQUIRE);
+    int64_t   bottom;
+    CDPointer result;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    bottom = __atomic_load_n(&self->bottom, __ATOMIC_ACQUIRE);
+
+    if (top >= bottom) {
+        return CDNull;
+    }
+
+    CDDequeArray* array = __atomic_load_n(&self->array, __ATOMIC_ACQUIRE);
+
+    result = __atomic_load_n(&array->item[top & array->mask], __ATOMIC_RELAXED);
+
+    if (!__atomic_compare_exchange_n(&self->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return CDNull;
+    }
+
+    return result;
+}
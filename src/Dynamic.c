@@ -23,3 +23,169 @@
  * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+
+#include <craftd/common.h>
+
+static struct {
+    CDHash*     atoms;
+    const char* names[CD_DYNAMIC_MAX];
+    int         length;
+
+    pthread_mutex_t lock;
+} cd_DynamicAtoms = { NULL, { NULL }, 0, PTHREAD_MUTEX_INITIALIZER };
+
+static
+CDDynamicSlots*
+cd_CreateDynamicSlots (int length)
+{
+    CDDynamicSlots* self = CD_malloc(sizeof(CDDynamicSlots) + sizeof(CDPointer) * length);
+
+    self->previous = NULL;
+    self->length   = length;
+
+    memset(self->item, 0, sizeof(CDPointer) * length);
+
+    return self;
+}
+
+int
+CD_DynamicAtom (const char* name)
+{
+    int atom;
+
+    assert(name);
+
+    pthread_mutex_lock(&cd_DynamicAtoms.lock);
+    if (!cd_DynamicAtoms.atoms) {
+        cd_DynamicAtoms.atoms = CD_CreateHash();
+    }
+
+    if ((atom = (int) CD_HashGet(cd_DynamicAtoms.atoms, name)) == 0) {
+        if (cd_DynamicAtoms.length + 1 >= CD_DYNAMIC_MAX) {
+            CD_abort("too many dynamic properties, %s can't be interned", name);
+        }
+
+        atom = cd_DynamicAtoms.length + 1;
+
+        cd_DynamicAtoms.names[atom] = strdup(name);
+        __atomic_store_n(&cd_DynamicAtoms.length, atom, __ATOMIC_RELEASE);
+        CD_HashPut(cd_DynamicAtoms.atoms, name, (CDPointer) atom);
+    }
+    pthread_mutex_unlock(&cd_DynamicAtoms.lock);
+
+    return atom;
+}
+
+const char*
+CD_DynamicAtomName (int atom)
+{
+    const char* result = NULL;
+
+    pthread_mutex_lock(&cd_DynamicAtoms.lock);
+    if (atom > 0 && atom <= cd_DynamicAtoms.length) {
+        result = cd_DynamicAtoms.names[atom];
+    }
+    pthread_mutex_unlock(&cd_DynamicAtoms.lock);
+
+    return result;
+}
+
+CDDynamic*
+CD_CreateDynamic (void)
+{
+    CDDynamic* self = CD_malloc(sizeof(CDDynamic));
+
+    // Properties are mostly interned by the time objects get created, so this usually never grows
+    self->slots = cd_CreateDynamicSlots(__atomic_load_n(&cd_DynamicAtoms.length, __ATOMIC_ACQUIRE) + 1);
+
+    if (pthread_spin_init(&self->lock, PTHREAD_PROCESS_PRIVATE) != 0) {
+        CD_abort("pthread spinlock failed to initialize");
+    }
+
+    return self;
+}
+
+void
+CD_DestroyDynamic (CDDynamic* self)
+{
+    assert(self);
+
+    while (self->slots) {
+        CDDynamicSlots* previous = self->slots->previous;
+
+        CD_free(self->slots);
+
+        self->slots = previous;
+    }
+
+    pthread_spin_destroy(&self->lock);
+
+    CD_free(self);
+}
+
+CDPointer
+CD_DynamicPutAtom (CDDynamic* self, int atom, CDPointer value)
+{
+    CDDynamicSlots* slots;
+    CDPointer       old;
+
+    assert(self);
+    assert(atom > 0);
+
+    pthread_spin_lock(&self->lock);
+    slots = self->slots;
+
+    if (atom >= slots->length) {
+        if (value == CDNull) {
+            pthread_spin_unlock(&self->lock);
+
+            return CDNull;
+        }
+
+        CDDynamicSlots* grown = cd_CreateDynamicSlots(CD_Max(atom + 1, slots->length * 2));
+
+        memcpy(grown->item, slots->item, sizeof(CDPointer) * slots->length);
+
+        // Readers might still be on the old array, it goes away with the Dynamic
+        grown->previous = slots;
+
+        __atomic_store_n(&self->slots, grown, __ATOMIC_RELEASE);
+
+        slots = grown;
+    }
+
+    old = slots->item[atom];
+
+    // Values are usually freshly built objects, readers must see them whole
+    __atomic_store_n(&slots->item[atom], value, __ATOMIC_RELEASE);
+    pthread_spin_unlock(&self->lock);
+
+    return old;
+}
+
+CDPointer
+CD_DynamicGetByName (CDDynamic* self, const char* name)
+{
+    assert(self);
+    assert(name);
+
+    return CD_DynamicGetAtom(self, CD_DynamicAtom(name));
+}
+
+CDPointer
+CD_DynamicPutByName (CDDynamic* self, const char* name, CDPointer value)
+{
+    assert(self);
+    assert(name);
+
+    return CD_DynamicPutAtom(self, CD_DynamicAtom(name), value);
+}
+
+CDPointer
+CD_DynamicDeleteByName (CDDynamic* self, const char* name)
+{
+    assert(self);
+    assert(name);
+
+    return CD_DynamicPutAtom(self, CD_DynamicAtom(name), CDNull);
+}
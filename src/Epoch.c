@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Epoch.h>
+
+typedef struct _CDEpochThread {
+    struct _CDEpochThread* next;
+
+    uint64_t epoch;
+    int      depth;
+    bool     used;
+} CDEpochThread;
+
+typedef struct _CDEpochRetired {
+    struct _CDEpochRetired* next;
+
+    void*                  pointer;
+    CDEpochDestroyCallback destroy;
+    uint64_t               epoch;
+} CDEpochRetired;
+
+static struct {
+    uint64_t epoch;
+
+    CDEpochThread*  threads;
+    CDEpochRetired* retired;
+    size_t          length;
+
+    pthread_key_t   key;
+    pthread_once_t  once;
+    pthread_mutex_t lock;
+} cd_Epoch = { 1, NULL, NULL, 0, 0, PTHREAD_ONCE_INIT, PTHREAD_MUTEX_INITIALIZER };
+
+static __thread CDEpochThread* cd_EpochCurrent = NULL;
+
+static
+void
+cd_EpochThreadExit (CDEpochThread* thread)
+{
+    __atomic_store_n(&thread->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&thread->used, false, __ATOMIC_RELEASE);
+}
+
+static
+void
+cd_EpochInitialize (void)
+{
+    pthread_key_create(&cd_Epoch.key, (void (*)(void*)) cd_EpochThreadExit);
+}
+
+static
+CDEpochThread*
+cd_EpochThread (void)
+{
+    CDEpochThread* thread;
+
+    if (cd_EpochCurrent) {
+        return cd_EpochCurrent;
+    }
+
+    pthread_once(&cd_Epoch.once, cd_EpochInitialize);
+
+    // Reuse the record of a thread that exited, records are never freed
+    for (thread = __atomic_load_n(&cd_Epoch.threads, __ATOMIC_ACQUIRE); thread; thread = thread->next) {
+        if (!__atomic_load_n(&thread->used, __ATOMIC_RELAXED) && __sync_bool_compare_and_swap(&thread->used, false, true)) {
+            goto done;
+        }
+    }
+
+    thread        = CD_malloc(sizeof(CDEpochThread));
+    thread->epoch = 0;
+    thread->depth = 0;
+    thread->used  = true;
+
+    do {
+        thread->next = __atomic_load_n(&cd_Epoch.threads, __ATOMIC_RELAXED);
+    } while (!__sync_bool_compare_and_swap(&cd_Epoch.threads, thread->next, thread));
+
+    done: {
+        pthread_setspecific(cd_Epoch.key, thread);
+
+        cd_EpochCurrent = thread;
+    }
+
+    return thread;
+}
+
+void
+CD_EpochEnter (void)
+{
+    CDEpochThread* thread = cd_EpochThread();
+
+    if (thread->depth++ == 0) {
+        __atomic_store_n(&thread->epoch, __atomic_load_n(&cd_Epoch.epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+        // The epoch has to be visible before any shared pointer is loaded
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+}
+
+void
+CD_EpochLeave (void)
+{
+    CDEpochThread* thread = cd_EpochCurrent;
+
+    assert(thread && thread->depth > 0);
+
+    if (--thread->depth == 0) {
+        __atomic_store_n(&thread->epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+void
+CD_EpochRetire (void* pointer, CDEpochDestroyCallback destroy)
+{
+    CDEpochRetired* retired = CD_malloc(sizeof(CDEpochRetired));
+
+    assert(destroy);
+
+    retired->pointer = pointer;
+    retired->destroy = destroy;
+
+    pthread_mutex_lock(&cd_Epoch.lock);
+    retired->epoch   = __atomic_load_n(&cd_Epoch.epoch, __ATOMIC_SEQ_CST);
+    retired->next    = cd_Epoch.retired;
+    cd_Epoch.retired = retired;
+    cd_Epoch.length++;
+    pthread_mutex_unlock(&cd_Epoch.lock);
+
+    CD_EpochCollect();
+}
+
+void
+CD_EpochCollect (void)
+{
+    CDEpochRetired*  done = NULL;
+    CDEpochRetired** link;
+    uint64_t         epoch;
+
+    pthread_mutex_lock(&cd_Epoch.lock);
+    epoch = __atomic_load_n(&cd_Epoch.epoch, __ATOMIC_SEQ_CST);
+
+    // The epoch moves on only when every reader has seen the current one
+    DO {
+        for (CDEpochThread* thread = __atomic_load_n(&cd_Epoch.threads, __ATOMIC_ACQUIRE); thread; thread = thread->next) {
+            uint64_t seen = __atomic_load_n(&thread->epoch, __ATOMIC_SEQ_CST);
+
+            if (seen != 0 && seen != epoch) {
+                goto collect;
+            }
+        }
+
+        __atomic_store_n(&cd_Epoch.epoch, ++epoch, __ATOMIC_SEQ_CST);
+    }
+
+    // Readers can be at most one epoch behind, two epochs later nobody can hold the pointer
+    collect: {
+        link = &cd_Epoch.retired;
+
+        while (*link) {
+            CDEpochRetired* current = *link;
+
+            if (current->epoch + 2 <= epoch) {
+                *link         = current->next;
+                current->next = done;
+                done          = current;
+
+                cd_Epoch.length--;
+            }
+            else {
+                link = &current->next;
+            }
+        }
+    }
+    pthread_mutex_unlock(&cd_Epoch.lock);
+
+    while (done) {
+        CDEpochRetired* next = done->next;
+
+        done->destroy(done->pointer);
+        CD_free(done);
+
+        done = next;
+    }
+}
+
+void
+CD_EpochFlush (void)
+{
+    CDEpochRetired* done;
+
+    pthread_mutex_lock(&cd_Epoch.lock);
+    done             = cd_Epoch.retired;
+    cd_Epoch.retired = NULL;
+    cd_Epoch.length  = 0;
+    pthread_mutex_unlock(&cd_Epoch.lock);
+
+    while (done) {
+        CDEpochRetired* next = done->next;
+
+        done->destroy(done->pointer);
+        CD_free(done);
+
+        done = next;
+    }
+}
@@ -25,29 +25,71 @@
 
 #include <craftd/Event.h>
 
+#include <dlfcn.h>
+#include <inttypes.h>
+
+static struct {
+    CDHash*     ids;
+    const char* names[CD_EVENT_MAX];
+    int         length;
+
+    pthread_mutex_t lock;
+} cd_EventAtoms = { NULL, { NULL }, 0, PTHREAD_MUTEX_INITIALIZER };
+
 static
-int8_t
-cd_EventIsEqual (CDEventCallbackFunction a, CDEventCallback* b)
+int
+cd_EventIntern (const char* eventName)
 {
-    if (a == b->function) {
-        return 0;
+    int id = (int) CD_HashGet(cd_EventAtoms.ids, eventName);
+
+    if (id == 0) {
+        if (cd_EventAtoms.length + 1 >= CD_EVENT_MAX) {
+            CD_abort("too many events, %s can't be interned", eventName);
+        }
+
+        id = ++cd_EventAtoms.length;
+
+        cd_EventAtoms.names[id] = strdup(eventName);
+        CD_HashPut(cd_EventAtoms.ids, eventName, (CDPointer) id);
     }
 
-    return 1;
+    return id;
 }
 
-int8_t
-cd_EventCompare (CDEventCallback* a, CDEventCallback* b)
+int
+CD_EventID (const char* eventName)
 {
-    if (a->priority > b->priority) {
-        return 1;
-    }
-    else if (a->priority < b->priority) {
-        return -1;
+    int id;
+
+    assert(eventName);
+
+    pthread_mutex_lock(&cd_EventAtoms.lock);
+    if (!cd_EventAtoms.ids) {
+        cd_EventAtoms.ids = CD_CreateHash();
+
+        // Keep the hooks at their reserved IDs
+        cd_EventIntern("Event.dispatch:before");
+        cd_EventIntern("Event.dispatch:after");
     }
-    else {
-        return 0;
+
+    id = cd_EventIntern(eventName);
+    pthread_mutex_unlock(&cd_EventAtoms.lock);
+
+    return id;
+}
+
+const char*
+CD_EventName (int id)
+{
+    const char* result = NULL;
+
+    pthread_mutex_lock(&cd_EventAtoms.lock);
+    if (id > 0 && id <= cd_EventAtoms.length) {
+        result = cd_EventAtoms.names[id];
     }
+    pthread_mutex_unlock(&cd_EventAtoms.lock);
+
+    return result;
 }
 
 CDEventCallback*
@@ -57,6 +99,7 @@ CD_CreateEventCallback (CDEventCallbackFunction function, int priority)
 
     self->function = function;
     self->priority = priority;
+    self->stats    = NULL;
 
     return self;
 }
@@ -125,28 +168,44 @@ CD_EventProvides (CDServer* server, const char* eventName, CDList* parameters)
 
     CD_HashPut(server->event.provided, eventName, (CDPointer) parameters);
 
+    CD_EventID(eventName);
+
     return true;
 }
 
+static
 bool
-cd_EventBeforeDispatch (CDServer* self, const char* eventName, ...)
+cd_EventRunHooks (CDServer* self, CDEventCallbacks* hooks, const char* eventName, va_list ap)
 {
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, "Event.dispatch:before");
-    bool    result    = true;
-    va_list ap;
+    for (size_t i = 0; hooks && i < hooks->length; i++) {
+        va_list copy;
+        bool    result;
 
-    va_start(ap, eventName);
-
-    CD_LIST_FOREACH(callbacks, it) {
-        if (!CD_ListIteratorValue(it)) {
-            continue;
-        }
+        va_copy(copy, ap);
+        result = hooks->item[i].function(self, eventName, copy);
+        va_end(copy);
 
-        if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, eventName, ap)) {
-            result = CD_LIST_BREAK(callbacks);
+        if (!result) {
+            return false;
         }
     }
 
+    return true;
+}
+
+bool
+cd_EventBeforeDispatch (CDServer* self, int id, const char* eventName, ...)
+{
+    bool    result;
+    va_list ap;
+
+    va_start(ap, eventName);
+
+    CD_EpochEnter();
+    result = cd_EventRunHooks(self, CD_EVENT_CALLBACKS(self, CD_EVENT_BEFORE), eventName, ap)
+          && cd_EventRunHooks(self, CD_EVENT_SUBSCRIBERS(self, id), eventName, ap);
+    CD_EpochLeave();
+
     va_end(ap);
 
     return result;
@@ -155,79 +214,721 @@ cd_EventBeforeDispatch (CDServer* self, const char* eventName, ...)
 bool
 cd_EventAfterDispatch (CDServer* self, const char* eventName, bool interrupted, ...)
 {
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, "Event.dispatch:after");
-    bool    result    = true;
-    va_list ap;
+    CDEventCallbacks* callbacks;
+    bool              result = true;
+    va_list           ap;
 
     va_start(ap, interrupted);
 
-    CD_LIST_FOREACH(callbacks, it) {
-        if (!CD_ListIteratorValue(it)) {
-            continue;
-        }
+    CD_EpochEnter();
+    callbacks = CD_EVENT_CALLBACKS(self, CD_EVENT_AFTER);
 
-        if (!((CDEventCallback*) CD_ListIteratorValue(it))->function(self, eventName, interrupted, ap)) {
-            result = CD_LIST_BREAK(callbacks);
+    for (size_t i = 0; callbacks && i < callbacks->length; i++) {
+        if (!callbacks->item[i].function(self, eventName, interrupted, ap)) {
+            result = false;
+            break;
         }
     }
+    CD_EpochLeave();
 
     va_end(ap);
 
     return result;
 }
 
+/**
+ * Publish a new version of the callbacks of an event and retire the old one,
+ * must be called with the event lock held
+ */
+static
+void
+cd_EventPublish (CDServer* self, CDEventCallbacks** table, int id, CDEventCallbacks* callbacks)
+{
+    CDEventCallbacks* old    = table[id];
+    size_t            length = callbacks ? callbacks->length : 0;
+
+    __atomic_store_n(&table[id], callbacks, __ATOMIC_RELEASE);
+
+    if (table == self->event.callbacks && id == CD_EVENT_BEFORE) {
+        __atomic_store_n(&self->event.hooks.before, length, __ATOMIC_RELAXED);
+    }
+    else if (table == self->event.callbacks && id == CD_EVENT_AFTER) {
+        __atomic_store_n(&self->event.hooks.after, length, __ATOMIC_RELAXED);
+    }
+
+    if (old) {
+        CD_EpochRetire(old, (CDEpochDestroyCallback) CD_free);
+    }
+}
+
+/**
+ * Copy the callbacks adding one, before the callbacks with the same priority like a sorted List push
+ */
+static
+CDEventCallbacks*
+cd_EventCallbacksInsert (CDEventCallbacks* old, CDEventCallbackFunction function, int priority, CDEventCallbackStats* stats)
+{
+    CDEventCallbacks* self;
+    size_t            length   = old ? old->length : 0;
+    size_t            position = 0;
+
+    while (position < length && old->item[position].priority < priority) {
+        position++;
+    }
+
+    self         = CD_malloc(sizeof(CDEventCallbacks) + (length + 1) * sizeof(CDEventCallback));
+    self->length = length + 1;
+
+    if (old) {
+        memcpy(self->item, old->item, position * sizeof(CDEventCallback));
+        memcpy(self->item + position + 1, old->item + position, (length - position) * sizeof(CDEventCallback));
+    }
+
+    self->item[position].function = function;
+    self->item[position].priority = priority;
+    self->item[position].stats    = stats;
+
+    return self;
+}
+
+/**
+ * Copy the callbacks without the given function, or without any if NULL, the removed
+ * callbacks are appended to removed when it's not NULL
+ *
+ * @return The new callbacks, NULL if none are left
+ */
+static
+CDEventCallbacks*
+cd_EventCallbacksRemove (CDEventCallbacks* old, CDEventCallbackFunction function, CDEventCallback** removed, size_t* length)
+{
+    CDEventCallbacks* self = CD_malloc(sizeof(CDEventCallbacks) + old->length * sizeof(CDEventCallback));
+
+    self->length = 0;
+
+    for (size_t i = 0; i < old->length; i++) {
+        if (!function || old->item[i].function == function) {
+            if (removed) {
+                removed[*length] = CD_CreateEventCallback(old->item[i].function, old->item[i].priority);
+            }
+
+            if (old->item[i].stats) {
+                CD_EpochRetire(old->item[i].stats, CD_free);
+            }
+
+            (*length)++;
+        }
+        else {
+            self->item[self->length++] = old->item[i];
+        }
+    }
+
+    if (self->length == 0) {
+        CD_free(self);
+
+        return NULL;
+    }
+
+    return self;
+}
+
 void
 CD_EventRegister (CDServer* self, const char* eventName, CDEventCallbackFunction callback)
 {
+    CD_EventRegisterWithPriority(self, eventName, 0, callback);
+}
+
+void
+CD_EventRegisterWithPriority (CDServer* self, const char* eventName, int priority, CDEventCallbackFunction callback)
+{
+    int id = CD_EventID(eventName);
+
     assert(self);
 
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, eventName);
+    pthread_mutex_lock(&self->event.lock);
+    cd_EventPublish(self, self->event.callbacks, id, cd_EventCallbacksInsert(self->event.callbacks[id], callback, priority,
+        CD_EVENT_PROFILING(self) ? CD_calloc(1, sizeof(CDEventCallbackStats)) : NULL));
+    pthread_mutex_unlock(&self->event.lock);
+}
 
-    if (!callbacks) {
-        callbacks = CD_CreateList();
-        CD_HashPut(self->event.callbacks, eventName, (CDPointer) callbacks);
+CDEventCallback**
+CD_EventUnregister (CDServer* self, const char* eventName, CDEventCallbackFunction callback)
+{
+    int               id      = CD_EventID(eventName);
+    CDEventCallback** result  = NULL;
+    size_t            removed = 0;
+    CDEventCallbacks* callbacks;
+
+    pthread_mutex_lock(&self->event.lock);
+    if (self->event.callbacks[id]) {
+        result    = CD_calloc(self->event.callbacks[id]->length + 1, sizeof(CDEventCallback*));
+        callbacks = cd_EventCallbacksRemove(self->event.callbacks[id], callback, result, &removed);
+
+        if (removed > 0) {
+            cd_EventPublish(self, self->event.callbacks, id, callbacks);
+        }
+        else {
+            CD_free(callbacks);
+        }
     }
+    pthread_mutex_unlock(&self->event.lock);
 
-    CD_ListSortedPush(callbacks, (CDPointer) CD_CreateEventCallback(callback, 0), (CDListCompareCallback) cd_EventCompare);
+    return result;
 }
 
 void
-CD_EventRegisterWithPriority (CDServer* self, const char* eventName, int priority, CDEventCallbackFunction callback)
+CD_EventSubscribe (CDServer* self, const char* eventName, CDEventCallbackFunction hook)
 {
+    int               id = CD_EventID(eventName);
+    CDEventCallbacks* hooks;
+
     assert(self);
+    assert(hook);
 
-    CDList* callbacks = (CDList*) CD_HashGet(self->event.callbacks, eventName);
+    pthread_mutex_lock(&self->event.lock);
+    hooks = self->event.subscribers[id];
 
-    if (!callbacks) {
-        callbacks = CD_CreateList();
-        CD_HashPut(self->event.callbacks, eventName, (CDPointer) callbacks);
+    for (size_t i = 0; hooks && i < hooks->length; i++) {
+        if (hooks->item[i].function == hook) {
+            goto done;
+        }
     }
 
-    CD_ListSortedPush(callbacks, (CDPointer) CD_CreateEventCallback(callback, priority), (CDListCompareCallback) cd_EventCompare);
+    cd_EventPublish(self, self->event.subscribers, id, cd_EventCallbacksInsert(hooks, hook, 0, NULL));
+
+    done: {
+        pthread_mutex_unlock(&self->event.lock);
+    }
 }
 
-CDEventCallback**
-CD_EventUnregister (CDServer* self, const char* eventName, CDEventCallbackFunction callback)
+void
+CD_EventUnsubscribe (CDServer* self, const char* eventName, CDEventCallbackFunction hook)
+{
+    int               id = eventName ? CD_EventID(eventName) : 1;
+    CDEventCallbacks* hooks;
+
+    assert(self);
+    assert(hook);
+
+    pthread_mutex_lock(&self->event.lock);
+    for (; id < CD_EVENT_MAX; id++) {
+        size_t removed = 0;
+
+        if (self->event.subscribers[id]) {
+            hooks = cd_EventCallbacksRemove(self->event.subscribers[id], hook, NULL, &removed);
+
+            if (removed > 0) {
+                cd_EventPublish(self, self->event.subscribers, id, hooks);
+            }
+            else {
+                CD_free(hooks);
+            }
+        }
+
+        if (eventName) {
+            break;
+        }
+    }
+    pthread_mutex_unlock(&self->event.lock);
+}
+
+static CDPool cd_EventAsyncPool = CD_POOL_INITIALIZER("CDEventAsync", sizeof(CDEventAsync));
+
+static
+CDPointer
+cd_EventCopyString (CDPointer value)
+{
+    return value ? (CDPointer) CD_CloneString((CDString*) value) : CDNull;
+}
+
+/**
+ * A Client whose last reference is gone can't be kept alive anymore, the dispatch is refused
+ */
+static
+CDPointer
+cd_EventCopyClient (CDPointer value)
+{
+    return value ? (CDPointer) CD_ClientTryRetain((CDClient*) value) : CDNull;
+}
+
+static
+void
+cd_EventReleaseClient (CDPointer value)
+{
+    if (value) {
+        CD_ClientRelease((CDClient*) value);
+    }
+}
+
+static
+void
+cd_EventReleaseString (CDPointer value)
+{
+    if (value) {
+        CD_DestroyString((CDString*) value);
+    }
+}
+
+static struct {
+    CDEventType item[32];
+    int         length;
+
+    pthread_mutex_t lock;
+} cd_EventTypes = {
+    .item = {
+        { "bool",     true,  NULL, NULL },
+        { "int",      true,  NULL, NULL },
+        { "CDClient", false, cd_EventCopyClient, cd_EventReleaseClient },
+        { "CDString", false, cd_EventCopyString, cd_EventReleaseString },
+    },
+
+    .length = 4,
+    .lock   = PTHREAD_MUTEX_INITIALIZER
+};
+
+/**
+ * Types nobody told how to copy are passed as they are
+ */
+static CDEventType cd_EventRawType = { NULL, false, NULL, NULL };
+
+void
+CD_EventRegisterType (const char* name, CDEventTypeCopy copy, CDEventTypeRelease release)
+{
+    assert(name);
+
+    pthread_mutex_lock(&cd_EventTypes.lock);
+    for (int i = 0; i < cd_EventTypes.length; i++) {
+        if (CD_CStringIsEqual(cd_EventTypes.item[i].name, name)) {
+            cd_EventTypes.item[i].copy    = copy;
+            cd_EventTypes.item[i].release = release;
+
+            goto done;
+        }
+    }
+
+    if (cd_EventTypes.length == 32) {
+        CD_abort("too many event types, %s can't be registered", name);
+    }
+
+    cd_EventTypes.item[cd_EventTypes.length].name    = strdup(name);
+    cd_EventTypes.item[cd_EventTypes.length].integer = false;
+    cd_EventTypes.item[cd_EventTypes.length].copy    = copy;
+    cd_EventTypes.item[cd_EventTypes.length].release = release;
+    cd_EventTypes.length++;
+
+    done: {
+        pthread_mutex_unlock(&cd_EventTypes.lock);
+    }
+}
+
+static
+CDEventType*
+cd_EventFindType (const char* name)
+{
+    CDEventType* result = &cd_EventRawType;
+
+    pthread_mutex_lock(&cd_EventTypes.lock);
+    for (int i = 0; i < cd_EventTypes.length; i++) {
+        if (CD_CStringIsEqual(cd_EventTypes.item[i].name, name)) {
+            result = &cd_EventTypes.item[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&cd_EventTypes.lock);
+
+    return result;
+}
+
+static
+CDEventSignature*
+cd_EventSignature (CDServer* self, int id, const char* eventName)
 {
-    CDList*           callbacks = (CDList*) CD_HashGet(self->event.callbacks, eventName);
-    CDEventCallback** result    = NULL;
+    CDEventSignature* signature = __atomic_load_n(&self->event.async.signatures[id], __ATOMIC_ACQUIRE);
+    CDList*           parameters;
 
-    if (!callbacks) {
+    if (signature) {
+        return signature;
+    }
+
+    if (!(parameters = (CDList*) CD_HashGet(self->event.provided, eventName))) {
         return NULL;
     }
 
-    if (callback) {
-        result    = CD_calloc(2, sizeof(CDEventCallback));
-        result[0] = (CDEventCallback*) CD_ListDeleteAllIf(callbacks, (CDPointer) callback,
-            (CDListCompareCallback) cd_EventIsEqual);
+    pthread_mutex_lock(&self->event.lock);
+    if (!(signature = self->event.async.signatures[id])) {
+        signature         = CD_malloc(sizeof(CDEventSignature) + CD_ListLength(parameters) * sizeof(CDEventType*));
+        signature->length = 0;
+
+        CD_LIST_FOREACH(parameters, it) {
+            signature->item[signature->length++] = cd_EventFindType((const char*) CD_ListIteratorValue(it));
+        }
+
+        __atomic_store_n(&self->event.async.signatures[id], signature, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&self->event.lock);
+
+    return signature;
+}
+
+/**
+ * Call a function with the Server and the parameters of an asynchronous dispatch
+ */
+#define CD_EVENT_APPLY(result, function, self, p, length, ...)                                        \
+    switch (length) {                                                                                   \
+        case 0: result = function(self, ##__VA_ARGS__); break;                                          \
+        case 1: result = function(self, ##__VA_ARGS__, p[0]); break;                                    \
+        case 2: result = function(self, ##__VA_ARGS__, p[0], p[1]); break;                              \
+        case 3: result = function(self, ##__VA_ARGS__, p[0], p[1], p[2]); break;                        \
+        case 4: result = function(self, ##__VA_ARGS__, p[0], p[1], p[2], p[3]); break;                  \
+        case 5: result = function(self, ##__VA_ARGS__, p[0], p[1], p[2], p[3], p[4]); break;            \
+        case 6: result = function(self, ##__VA_ARGS__, p[0], p[1], p[2], p[3], p[4], p[5]); break;      \
+    }
+
+/**
+ * Release the copied parameters of an asynchronous dispatch and free it
+ */
+static
+void
+cd_EventFreeAsync (CDEventAsync* async, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        if (async->signature->item[i]->release) {
+            async->signature->item[i]->release(async->parameters[i]);
+        }
+    }
+
+    CD_PoolFree(&cd_EventAsyncPool, async);
+}
+
+/**
+ * Free a dispatch that was queued and wake who's waiting for the pending ones
+ */
+static
+void
+cd_EventFinishAsync (CDEventAsync* async)
+{
+    CDServer* self = async->server;
+
+    cd_EventFreeAsync(async, async->signature->length);
+
+    if (__sync_sub_and_fetch(&self->event.async.pending, 1) == 0) {
+        pthread_mutex_lock(&self->event.lock);
+        pthread_cond_broadcast(&self->event.async.drained);
+        pthread_mutex_unlock(&self->event.lock);
+    }
+}
+
+static
+void
+cd_EventRunAsync (CDEventAsync* async)
+{
+    CDServer*         self        = async->server;
+    CDPointer*        parameters  = async->parameters;
+    size_t            length      = async->signature->length;
+    const char*       eventName   = CD_EventName(async->id);
+    bool              interrupted = false;
+    bool              result      = true;
+    CDEventCallbacks* callbacks;
+
+    if (CD_EVENT_INTERCEPTED(self, async->id)) {
+        CD_EVENT_APPLY(result, cd_EventBeforeDispatch, self, parameters, length, async->id, eventName);
+    }
+
+    if (result) {
+        CDEventStats* profile = CD_EVENT_PROFILING(self);
+        uint64_t      started = profile ? CD_MonotonicTime() : 0;
+
+        CD_EpochEnter();
+        callbacks = CD_EVENT_CALLBACKS(self, async->id);
+
+        for (size_t i = 0; callbacks && i < callbacks->length; i++) {
+            uint64_t called = profile ? CD_MonotonicTime() : 0;
+
+            CD_EVENT_APPLY(result, callbacks->item[i].function, self, parameters, length);
+
+            if (profile) {
+                cd_EventProfileCallback(&callbacks->item[i], called, !result);
+            }
+
+            if (!result) {
+                interrupted = true;
+                break;
+            }
+        }
+
+        if (profile) {
+            cd_EventProfileDispatch(self, async->id, started);
+        }
+        CD_EpochLeave();
+
+        if (CD_EVENT_HOOKED(self, after)) {
+            CD_EVENT_APPLY(result, cd_EventAfterDispatch, self, parameters, length, eventName, interrupted);
+        }
+    }
+
+    cd_EventFinishAsync(async);
+}
+
+static
+void
+cd_EventRunLane (CDEventLane* lane)
+{
+    CDEventAsync* async;
+
+    for (int done = 0; true; done++) {
+        // Let the other Jobs run, the Lane stays scheduled
+        if (done == lane->server->config->cache.scheduler.lane.batch) {
+            CD_AddJobWithPriority(lane->server->workers, CD_CreateJob(CDCustomJob,
+                (CDPointer) CD_CreateCustomJob((CDCustomJobCallback) cd_EventRunLane, (CDPointer) lane)), CDJobBulk);
+
+            return;
+        }
+
+        if (!(async = (CDEventAsync*) CD_LaneShift(lane->lane))) {
+            if (CD_LaneFinish(lane->lane)) {
+                return;
+            }
+
+            continue;
+        }
+
+        cd_EventRunAsync(async);
+    }
+}
+
+bool
+cd_EventDispatchAsync (CDServer* self, int id, const char* eventName, uint64_t key, ...)
+{
+    CDEventSignature* signature = cd_EventSignature(self, id, eventName);
+    CDEventAsync*     async;
+    va_list           ap;
+
+    if (!signature || signature->length > CD_EVENT_ASYNC_MAX) {
+        SERR(self, "Event %s can't be dispatched asynchronously", eventName);
+
+        return false;
+    }
+
+    async            = CD_PoolAlloc(&cd_EventAsyncPool);
+    async->server    = self;
+    async->signature = signature;
+    async->id        = id;
+
+    va_start(ap, key);
+    for (size_t i = 0; i < signature->length; i++) {
+        if (signature->item[i]->integer) {
+            async->parameters[i] = (CDPointer) va_arg(ap, int);
+        }
+        else {
+            async->parameters[i] = va_arg(ap, CDPointer);
+        }
+
+        if (signature->item[i]->copy && async->parameters[i]) {
+            // The value is going away, the callbacks would get it dangling
+            if (!(async->parameters[i] = signature->item[i]->copy(async->parameters[i]))) {
+                va_end(ap);
+
+                cd_EventFreeAsync(async, i);
+
+                return false;
+            }
+        }
+    }
+    va_end(ap);
+
+    __sync_fetch_and_add(&self->event.async.pending, 1);
+
+    if (key == 0) {
+        CD_AddJobWithPriority(self->workers, CD_CreateJob(CDCustomJob,
+            (CDPointer) CD_CreateCustomJob((CDCustomJobCallback) cd_EventRunAsync, (CDPointer) async)), CDJobBulk);
     }
     else {
-        result = (CDEventCallback**) CD_ListClear(callbacks);
+        CDEventLane* lane = &self->event.async.lanes[((key * 0x9E3779B97F4A7C15ULL) >> 32) % CD_EVENT_LANES];
+
+        if (CD_LanePush(lane->lane, (CDPointer) async)) {
+            CD_AddJobWithPriority(self->workers, CD_CreateJob(CDCustomJob,
+                (CDPointer) CD_CreateCustomJob((CDCustomJobCallback) cd_EventRunLane, (CDPointer) lane)), CDJobBulk);
+        }
+    }
+
+    return true;
+}
+
+void
+CD_EventWaitAsync (CDServer* self)
+{
+    assert(self);
+    assert(!CD_CurrentWorker());
+
+    // Nobody would run them
+    if (!self->workers || __atomic_load_n(&self->workers->length, __ATOMIC_ACQUIRE) == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&self->event.lock);
+    while (__atomic_load_n(&self->event.async.pending, __ATOMIC_ACQUIRE) > 0) {
+        pthread_cond_wait(&self->event.async.drained, &self->event.lock);
+    }
+    pthread_mutex_unlock(&self->event.lock);
+}
+
+void
+CD_EventDropAsync (CDServer* self)
+{
+    CDEventAsync* async;
+
+    assert(self);
+
+    for (int i = 0; i < CD_EVENT_LANES; i++) {
+        while ((async = (CDEventAsync*) CD_LaneShift(self->event.async.lanes[i].lane))) {
+            cd_EventFinishAsync(async);
+        }
+    }
+}
+
+static inline
+void
+cd_EventProfileMax (uint64_t* max, uint64_t value)
+{
+    uint64_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+
+    while (value > current && !__atomic_compare_exchange_n(max, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        continue;
+    }
+}
+
+void
+cd_EventProfileCallback (CDEventCallback* callback, uint64_t started, bool interrupted)
+{
+    CDEventCallbackStats* stats   = callback->stats;
+    uint64_t              elapsed = CD_MonotonicTime() - started;
+
+    // Registered before the profiler was on
+    if (!stats) {
+        return;
+    }
+
+    __atomic_fetch_add(&stats->calls, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->time, elapsed, __ATOMIC_RELAXED);
+
+    if (interrupted) {
+        __atomic_fetch_add(&stats->interrupts, 1, __ATOMIC_RELAXED);
     }
 
-    if (CD_ListLength(callbacks) == 0) {
-        CD_DestroyList(callbacks);
+    cd_EventProfileMax(&stats->max, elapsed);
+}
+
+void
+cd_EventProfileDispatch (CDServer* self, int id, uint64_t started)
+{
+    CDEventStats* stats   = &CD_EVENT_PROFILING(self)[id];
+    uint64_t      elapsed = CD_MonotonicTime() - started;
+
+    __atomic_fetch_add(&stats->dispatches, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&stats->time, elapsed, __ATOMIC_RELAXED);
+
+    cd_EventProfileMax(&stats->max, elapsed);
+}
+
+bool
+CD_EventStats (CDServer* self, const char* eventName, CDEventStats* stats)
+{
+    CDEventStats* profile = CD_EVENT_PROFILING(self);
+    int           id      = CD_EventID(eventName);
+
+    assert(stats);
+
+    if (!profile) {
+        return false;
+    }
+
+    stats->dispatches = __atomic_load_n(&profile[id].dispatches, __ATOMIC_RELAXED);
+    stats->time       = __atomic_load_n(&profile[id].time, __ATOMIC_RELAXED);
+    stats->max        = __atomic_load_n(&profile[id].max, __ATOMIC_RELAXED);
+
+    return true;
+}
+
+size_t
+CD_EventCallbacksStats (CDServer* self, const char* eventName, CDEventCallbackFunction* functions, CDEventCallbackStats* stats, size_t length)
+{
+    CDEventCallbacks* callbacks;
+    size_t            result;
+
+    CD_EpochEnter();
+    callbacks = CD_EVENT_CALLBACKS(self, CD_EventID(eventName));
+    result    = callbacks ? callbacks->length : 0;
+
+    for (size_t i = 0; i < result && i < length; i++) {
+        functions[i] = callbacks->item[i].function;
+
+        if (callbacks->item[i].stats) {
+            stats[i].calls      = __atomic_load_n(&callbacks->item[i].stats->calls, __ATOMIC_RELAXED);
+            stats[i].interrupts = __atomic_load_n(&callbacks->item[i].stats->interrupts, __ATOMIC_RELAXED);
+            stats[i].time       = __atomic_load_n(&callbacks->item[i].stats->time, __ATOMIC_RELAXED);
+            stats[i].max        = __atomic_load_n(&callbacks->item[i].stats->max, __ATOMIC_RELAXED);
+        }
+        else {
+            memset(&stats[i], 0, sizeof(CDEventCallbackStats));
+        }
+    }
+    CD_EpochLeave();
+
+    return result;
+}
+
+CDString*
+CD_EventProfileReport (CDServer* self)
+{
+    CDEventStats* profile = CD_EVENT_PROFILING(self);
+    CDString*     result;
+
+    if (!profile) {
+        return NULL;
+    }
+
+    result = CD_CreateString();
+
+    CD_EpochEnter();
+    for (int id = 1; id < CD_EVENT_MAX; id++) {
+        CDEventCallbacks* callbacks  = CD_EVENT_CALLBACKS(self, id);
+        uint64_t          dispatches = __atomic_load_n(&profile[id].dispatches, __ATOMIC_RELAXED);
+        uint64_t          time       = __atomic_load_n(&profile[id].time, __ATOMIC_RELAXED);
+
+        if (dispatches == 0) {
+            continue;
+        }
+
+        result = CD_AppendStringAndClean(result, CD_CreateStringFromFormat(
+            "%s: %" PRIu64 " dispatches, %.3fms total, %.2fus average, %.2fus max\n",
+            CD_EventName(id), dispatches, time / 1000000.0, (double) time / dispatches / 1000.0,
+            __atomic_load_n(&profile[id].max, __ATOMIC_RELAXED) / 1000.0));
+
+        for (size_t i = 0; callbacks && i < callbacks->length; i++) {
+            CDEventCallbackStats* stats = callbacks->item[i].stats;
+            Dl_info               info;
+            const char*           name  = NULL;
+
+            if (!stats) {
+                continue;
+            }
+
+            if (dladdr((void*) callbacks->item[i].function, &info) && info.dli_saddr == (void*) callbacks->item[i].function) {
+                name = info.dli_sname;
+            }
+
+            DO {
+                uint64_t calls = __atomic_load_n(&stats->calls, __ATOMIC_RELAXED);
+                uint64_t spent = __atomic_load_n(&stats->time, __ATOMIC_RELAXED);
+
+                result = CD_AppendStringAndClean(result, CD_CreateStringFromFormat(
+                    "    %s%s%p (priority %d): %" PRIu64 " calls, %" PRIu64 " interrupts, %.3fms total, %.2fus average, %.2fus max\n",
+                    name ? name : "", name ? " " : "", (void*) callbacks->item[i].function, callbacks->item[i].priority,
+                    calls, __atomic_load_n(&stats->interrupts, __ATOMIC_RELAXED), spent / 1000000.0,
+                    calls ? (double) spent / calls / 1000.0 : 0.0, __atomic_load_n(&stats->max, __ATOMIC_RELAXED) / 1000.0));
+            }
+        }
     }
+    CD_EpochLeave();
 
     return result;
 }
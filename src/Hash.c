@@ -26,17 +26,199 @@
 #include <craftd/common.h>
 #include <craftd/Hash.h>
 
+static inline
+CDHashShard*
+cd_HashShard (CDHash* self, const char* name)
+{
+    if (self->shards == 1) {
+        return &self->shard[0];
+    }
+
+    // khash indexes with the low bits, the shard comes from the high ones
+    return &self->shard[((uint32_t) kh_str_hash_func(name) * 0x9E3779B1U) >> 24 & (self->shards - 1)];
+}
+
+static
+const char*
+cd_HashKeysCopy (CDHashShard* shard, const char* name)
+{
+    size_t       length = strlen(name) + 1;
+    CDHashBlock* block  = shard->keys.blocks;
+    char*        result;
+
+    if (block == NULL || block->length + length > block->size) {
+        size_t size = CD_Max(CD_HASH_BLOCK, length);
+
+        block         = CD_malloc(sizeof(CDHashBlock) + size);
+        block->next   = shard->keys.blocks;
+        block->length = 0;
+        block->live   = 0;
+        block->size   = size;
+
+        shard->keys.blocks = block;
+    }
+
+    result         = block->data + block->length;
+    block->length += length;
+    block->live   += length;
+
+    memcpy(result, name, length);
+
+    return result;
+}
+
+static
+void
+cd_HashKeysFree (CDHashShard* shard)
+{
+    CDHashBlock* block = shard->keys.blocks;
+
+    while (block) {
+        CDHashBlock* next = block->next;
+
+        CD_free(block);
+
+        block = next;
+    }
+
+    shard->keys.blocks = NULL;
+}
+
+/**
+ * Forget a key, keys never move so the others stay valid until they're
+ * deleted themselves. A block is freed once all its keys are gone, the
+ * current one is reused instead.
+ */
+static
+void
+cd_HashKeysRelease (CDHashShard* shard, const char* key)
+{
+    size_t        length = strlen(key) + 1;
+    CDHashBlock** link   = &shard->keys.blocks;
+
+    if (kh_size(shard->raw) == 0) {
+        cd_HashKeysFree(shard);
+
+        return;
+    }
+
+    while (*link && !(key >= (*link)->data && key < (*link)->data + (*link)->length)) {
+        link = &(*link)->next;
+    }
+
+    assert(*link);
+
+    CDHashBlock* block = *link;
+
+    if ((block->live -= length) > 0) {
+        return;
+    }
+
+    if (block == shard->keys.blocks) {
+        block->length = 0;
+    }
+    else {
+        *link = block->next;
+
+        CD_free(block);
+    }
+}
+
+/**
+ * Move the iterator to the first element at or after its position in its
+ * shard, the shard has to be locked.
+ */
+static
+bool
+cd_HashSeek (CDHashIterator* it)
+{
+    khash_t(cdHash)* raw = it->parent->shard[it->shard].raw;
+
+    for (; it->raw < kh_end(raw); it->raw++) {
+        if (kh_exist(raw, it->raw)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Move the iterator to the first element at or before its position in its
+ * shard, the shard has to be locked.
+ */
+static
+bool
+cd_HashSeekBack (CDHashIterator* it)
+{
+    khash_t(cdHash)* raw = it->parent->shard[it->shard].raw;
+
+    if (kh_end(raw) == 0) {
+        return false;
+    }
+
+    if (it->raw >= kh_end(raw)) {
+        it->raw = kh_end(raw) - 1;
+    }
+
+    while (!kh_exist(raw, it->raw)) {
+        if (it->raw == kh_begin(raw)) {
+            return false;
+        }
+
+        it->raw--;
+    }
+
+    return true;
+}
+
+/**
+ * Find the next element from the iterator position, locking shard by shard
+ * and keeping the one it stops in locked.
+ */
+static
+CDHashIterator
+cd_HashIterate (CDHashIterator it)
+{
+    while (!cd_HashSeek(&it)) {
+        pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
+
+        it.raw = 0;
+
+        if (++it.shard >= it.parent->shards) {
+            break;
+        }
+
+        pthread_rwlock_rdlock(&it.parent->shard[it.shard].lock);
+    }
+
+    return it;
+}
+
 CDHash*
 CD_CreateHash (void)
 {
-    CDHash* self = CD_malloc(sizeof(CDHash));
+    return CD_CreateHashWith(CDHashDefault);
+}
+
+CDHash*
+CD_CreateHashWith (CDHashFlags flags)
+{
+    size_t  shards = (flags & CDHashStriped) ? CD_HASH_SHARDS : 1;
+    CDHash* self   = CD_malloc(sizeof(CDHash) + sizeof(CDHashShard) * shards);
+
+    self->length = 0;
+    self->shards = shards;
 
-    self->raw = kh_init(cdHash);
+    for (size_t i = 0; i < shards; i++) {
+        self->shard[i].raw         = kh_init(cdHash);
+        self->shard[i].keys.blocks = NULL;
 
-    assert(self->raw);
+        assert(self->shard[i].raw);
 
-    if (pthread_rwlock_init(&self->lock, NULL) != 0) {
-        CD_abort("pthread rwlock failed to initialize");
+        if (pthread_rwlock_init(&self->shard[i].lock, NULL) != 0) {
+            CD_abort("pthread rwlock failed to initialize");
+        }
     }
 
     return self;
@@ -45,10 +227,10 @@ CD_CreateHash (void)
 CDHash*
 CD_CloneHash (CDHash* self)
 {
-    CDHash* cloned = CD_CreateHash();
-
     assert(self);
 
+    CDHash* cloned = CD_CreateHashWith(self->shards > 1 ? CDHashStriped : CDHashDefault);
+
     CD_HASH_FOREACH(self, it) {
         CD_HashPut(cloned, CD_HashIteratorKey(it), CD_HashIteratorValue(it));
     }
@@ -61,13 +243,13 @@ CD_DestroyHash (CDHash* self)
 {
     assert(self);
 
-    CD_HASH_FOREACH(self, it) {
-        free((void*) CD_HashIteratorKey(it));
-    }
+    for (size_t i = 0; i < self->shards; i++) {
+        cd_HashKeysFree(&self->shard[i]);
 
-    kh_destroy(cdHash, self->raw);
+        kh_destroy(cdHash, self->shard[i].raw);
 
-    pthread_rwlock_destroy(&self->lock);
+        pthread_rwlock_destroy(&self->shard[i].lock);
+    }
 
     CD_free(self);
 }
@@ -75,15 +257,9 @@ CD_DestroyHash (CDHash* self)
 size_t
 CD_HashLength (CDHash* self)
 {
-    size_t result;
-
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
-    result = kh_size(self->raw);
-    pthread_rwlock_unlock(&self->lock);
-
-    return result;
+    return __atomic_load_n(&self->length, __ATOMIC_ACQUIRE);
 }
 
 CDHashIterator
@@ -93,16 +269,23 @@ CD_HashBegin (CDHash* self)
 
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
-    it.raw    = kh_end(self->raw);
+    it.shard  = 0;
+    it.raw    = 0;
     it.parent = self;
 
-    if (!kh_exist(self->raw, it.raw)) {
-        it = CD_HashNext(it);
+    for (; it.shard < self->shards; it.shard++, it.raw = 0) {
+        bool found;
+
+        pthread_rwlock_rdlock(&self->shard[it.shard].lock);
+        found = cd_HashSeek(&it);
+        pthread_rwlock_unlock(&self->shard[it.shard].lock);
+
+        if (found) {
+            return it;
+        }
     }
-    pthread_rwlock_unlock(&self->lock);
 
-    return it;
+    return CD_HashEnd(self);
 }
 
 CDHashIterator
@@ -112,10 +295,9 @@ CD_HashEnd (CDHash* self)
 
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
-    it.raw    = kh_begin(self->raw) - 1;
+    it.shard  = self->shards;
+    it.raw    = 0;
     it.parent = self;
-    pthread_rwlock_unlock(&self->lock);
 
     return it;
 }
@@ -123,51 +305,68 @@ CD_HashEnd (CDHash* self)
 CDHashIterator
 CD_HashNext (CDHashIterator it)
 {
-    if (it.raw == kh_begin(it.parent->raw)) {
-        return CD_HashEnd(it.parent);
+    if (it.shard >= it.parent->shards) {
+        return it;
     }
 
-    it.raw--;
+    for (it.raw++; it.shard < it.parent->shards; it.shard++, it.raw = 0) {
+        bool found;
 
-    pthread_rwlock_rdlock(&it.parent->lock);
-    for (; it.raw != kh_begin(it.parent->raw) && !kh_exist(it.parent->raw, it.raw); it.raw--) {
-        continue;
-    }
+        pthread_rwlock_rdlock(&it.parent->shard[it.shard].lock);
+        found = cd_HashSeek(&it);
+        pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
 
-    if (!kh_exist(it.parent->raw, it.raw)) {
-        it = CD_HashEnd(it.parent);
+        if (found) {
+            return it;
+        }
     }
-    pthread_rwlock_unlock(&it.parent->lock);
 
-    return it;
+    return CD_HashEnd(it.parent);
 }
 
 CDHashIterator
 CD_HashPrevious (CDHashIterator it)
 {
-    if (it.raw == kh_end(it.parent->raw)) {
-        return CD_HashBegin(it.parent);
+    if (it.shard >= it.parent->shards) {
+        it.shard = it.parent->shards - 1;
+        it.raw   = (khiter_t) -1;
     }
+    else if (it.raw == 0) {
+        if (it.shard == 0) {
+            return CD_HashEnd(it.parent);
+        }
 
-    it.raw++;
-
-    pthread_rwlock_rdlock(&it.parent->lock);
-    for (; it.raw != kh_end(it.parent->raw) && !kh_exist(it.parent->raw, it.raw); it.raw++) {
-        continue;
+        it.shard--;
+        it.raw = (khiter_t) -1;
     }
-
-    if (!kh_exist(it.parent->raw, it.raw)) {
-        it = CD_HashBegin(it.parent);
+    else {
+        it.raw--;
     }
-    pthread_rwlock_unlock(&it.parent->lock);
 
-    return it;
+    while (true) {
+        bool found;
+
+        pthread_rwlock_rdlock(&it.parent->shard[it.shard].lock);
+        found = cd_HashSeekBack(&it);
+        pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
+
+        if (found) {
+            return it;
+        }
+
+        if (it.shard == 0) {
+            return CD_HashEnd(it.parent);
+        }
+
+        it.shard--;
+        it.raw = (khiter_t) -1;
+    }
 }
 
 bool
 CD_HashIteratorIsEqual (CDHashIterator a, CDHashIterator b)
 {
-    return a.raw == b.raw && a.parent == b.parent;
+    return a.shard == b.shard && a.raw == b.raw && a.parent == b.parent;
 }
 
 const char*
@@ -175,9 +374,13 @@ CD_HashIteratorKey (CDHashIterator it)
 {
     const char* result = NULL;
 
-    pthread_rwlock_rdlock(&it.parent->lock);
-    result = kh_key(it.parent->raw, it.raw);
-    pthread_rwlock_unlock(&it.parent->lock);
+    if (it.shard >= it.parent->shards) {
+        return NULL;
+    }
+
+    pthread_rwlock_rdlock(&it.parent->shard[it.shard].lock);
+    result = kh_key(it.parent->shard[it.shard].raw, it.raw);
+    pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
 
     return result;
 }
@@ -187,9 +390,13 @@ CD_HashIteratorValue (CDHashIterator it)
 {
     CDPointer result = CDNull;
 
-    pthread_rwlock_rdlock(&it.parent->lock);
-    result = kh_value(it.parent->raw, it.raw);
-    pthread_rwlock_unlock(&it.parent->lock);
+    if (it.shard >= it.parent->shards) {
+        return CDNull;
+    }
+
+    pthread_rwlock_rdlock(&it.parent->shard[it.shard].lock);
+    result = kh_value(it.parent->shard[it.shard].raw, it.raw);
+    pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
 
     return result;
 }
@@ -199,9 +406,15 @@ CD_HashIteratorValid (CDHashIterator it)
 {
     bool result = false;
 
-    pthread_rwlock_rdlock(&it.parent->lock);
-    result = kh_exist(it.parent->raw, it.raw);
-    pthread_rwlock_unlock(&it.parent->lock);
+    if (it.shard >= it.parent->shards) {
+        return false;
+    }
+
+    pthread_rwlock_rdlock(&it.parent->shard[it.shard].lock);
+    if (it.raw < kh_end(it.parent->shard[it.shard].raw)) {
+        result = kh_exist(it.parent->shard[it.shard].raw, it.raw);
+    }
+    pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
 
     return result;
 }
@@ -209,15 +422,16 @@ CD_HashIteratorValid (CDHashIterator it)
 bool
 CD_HashHasKey (CDHash* self, const char* name)
 {
-    bool result = false;
+    CDHashShard* shard  = cd_HashShard(self, name);
+    bool         result = false;
 
-    pthread_rwlock_rdlock(&self->lock);
-    khiter_t it = kh_get(cdHash, self->raw, name);
+    pthread_rwlock_rdlock(&shard->lock);
+    khiter_t it = kh_get(cdHash, shard->raw, name);
 
-    if (it != kh_end(self->raw)) {
-        result = kh_exist(self->raw, it);
+    if (it != kh_end(shard->raw)) {
+        result = kh_exist(shard->raw, it);
     }
-    pthread_rwlock_unlock(&self->lock);
+    pthread_rwlock_unlock(&shard->lock);
 
     return result;
 }
@@ -225,19 +439,22 @@ CD_HashHasKey (CDHash* self, const char* name)
 CDPointer
 CD_HashGet (CDHash* self, const char* name)
 {
-    CDPointer result = (CDPointer) NULL;
-    khiter_t  it;
+    CDPointer    result = (CDPointer) NULL;
+    CDHashShard* shard;
+    khiter_t     it;
 
     assert(self);
     assert(name);
 
-    pthread_rwlock_rdlock(&self->lock);
-    it = kh_get(cdHash, self->raw, name);
+    shard = cd_HashShard(self, name);
+
+    pthread_rwlock_rdlock(&shard->lock);
+    it = kh_get(cdHash, shard->raw, name);
 
-    if (it != kh_end(self->raw) && kh_exist(self->raw, it)) {
-        result = kh_value(self->raw, it);
+    if (it != kh_end(shard->raw) && kh_exist(shard->raw, it)) {
+        result = kh_value(shard->raw, it);
     }
-    pthread_rwlock_unlock(&self->lock);
+    pthread_rwlock_unlock(&shard->lock);
 
     return result;
 }
@@ -245,25 +462,30 @@ CD_HashGet (CDHash* self, const char* name)
 CDPointer
 CD_HashPut (CDHash* self, const char* name, CDPointer data)
 {
-    CDPointer old = (CDPointer) NULL;
-    khiter_t  it;
-    int       ret;
+    CDPointer    old = (CDPointer) NULL;
+    CDHashShard* shard;
+    khiter_t     it;
+    int          ret;
 
     assert(self);
     assert(name);
 
-    pthread_rwlock_wrlock(&self->lock);
-    it = kh_get(cdHash, self->raw, name);
+    shard = cd_HashShard(self, name);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    it = kh_get(cdHash, shard->raw, name);
 
-    if (it != kh_end(self->raw) && kh_exist(self->raw, it)) {
-        old = kh_value(self->raw, it);
+    if (it != kh_end(shard->raw) && kh_exist(shard->raw, it)) {
+        old = kh_value(shard->raw, it);
     }
     else {
-        it = kh_put(cdHash, self->raw, strdup(name), &ret);
+        it = kh_put(cdHash, shard->raw, cd_HashKeysCopy(shard, name), &ret);
+
+        __sync_fetch_and_add(&self->length, 1);
     }
 
-    kh_value(self->raw, it) = data;
-    pthread_rwlock_unlock(&self->lock);
+    kh_value(shard->raw, it) = data;
+    pthread_rwlock_unlock(&shard->lock);
 
     return old;
 }
@@ -271,23 +493,30 @@ CD_HashPut (CDHash* self, const char* name, CDPointer data)
 CDPointer
 CD_HashDelete (CDHash* self, const char* name)
 {
-    CDPointer old = (CDPointer) NULL;
-    khiter_t  it;
+    CDPointer    old = (CDPointer) NULL;
+    CDHashShard* shard;
+    khiter_t     it;
 
     assert(self);
     assert(name);
 
-    pthread_rwlock_wrlock(&self->lock);
-    it = kh_get(cdHash, self->raw, name);
+    shard = cd_HashShard(self, name);
 
-    if (it != kh_end(self->raw) && kh_exist(self->raw, it)) {
-        old = kh_value(self->raw, it);
+    pthread_rwlock_wrlock(&shard->lock);
+    it = kh_get(cdHash, shard->raw, name);
 
-        free((char*) kh_key(self->raw, it));
-    }
+    if (it != kh_end(shard->raw) && kh_exist(shard->raw, it)) {
+        const char* key = kh_key(shard->raw, it);
 
-    kh_del(cdHash, self->raw, it);
-    pthread_rwlock_unlock(&self->lock);
+        old = kh_value(shard->raw, it);
+
+        kh_del(cdHash, shard->raw, it);
+
+        cd_HashKeysRelease(shard, key);
+
+        __sync_fetch_and_sub(&self->length, 1);
+    }
+    pthread_rwlock_unlock(&shard->lock);
 
     return old;
 }
@@ -307,46 +536,75 @@ CD_HashLast (CDHash* self)
 CDPointer*
 CD_HashClear (CDHash* self)
 {
-    CDPointer* result = CD_malloc(sizeof(CDPointer) * (CD_HashLength(self) + 1));
+    CDPointer* result;
+    size_t     length = 0;
     size_t     i      = 0;
-    khiter_t   it;
 
     assert(self);
-    assert(result);
 
-    pthread_rwlock_wrlock(&self->lock);
-    for (it = kh_begin(self->raw); it != kh_end(self->raw); it++) {
-        if (kh_exist(self->raw, it)) {
-            free((void*) kh_key(self->raw, it));
-            result[i++] = kh_value(self->raw, it);
+    // All the shards are held so the array can't come up short
+    for (size_t shard = 0; shard < self->shards; shard++) {
+        pthread_rwlock_wrlock(&self->shard[shard].lock);
+
+        length += kh_size(self->shard[shard].raw);
+    }
+
+    result = CD_malloc(sizeof(CDPointer) * (length + 1));
+
+    for (size_t shard = 0; shard < self->shards; shard++) {
+        khash_t(cdHash)* raw = self->shard[shard].raw;
+
+        for (khiter_t it = kh_begin(raw); it != kh_end(raw); it++) {
+            if (kh_exist(raw, it)) {
+                result[i++] = kh_value(raw, it);
+            }
         }
+
+        kh_clear(cdHash, raw);
+
+        cd_HashKeysFree(&self->shard[shard]);
     }
 
     result[i] = CDNull;
 
-    kh_clear(cdHash, self->raw);
-    pthread_rwlock_unlock(&self->lock);
+    __sync_fetch_and_sub(&self->length, length);
+
+    for (size_t shard = self->shards; shard > 0; shard--) {
+        pthread_rwlock_unlock(&self->shard[shard - 1].lock);
+    }
 
     return result;
 }
 
-bool
+CDHashIterator
 CD_HashStartIterating (CDHash* self)
 {
+    CDHashIterator it;
+
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
+    it.shard  = 0;
+    it.raw    = 0;
+    it.parent = self;
 
-    return true;
+    pthread_rwlock_rdlock(&self->shard[0].lock);
+
+    return cd_HashIterate(it);
 }
 
-bool
-CD_HashStopIterating (CDHash* self, bool stop)
+CDHashIterator
+CD_HashIteratingNext (CDHashIterator it)
 {
-    assert(self);
+    it.raw++;
 
-    if (!stop) {
-        pthread_rwlock_unlock(&self->lock);
+    return cd_HashIterate(it);
+}
+
+bool
+CD_HashStopIterating (CDHashIterator it, bool stop)
+{
+    if (!stop && it.shard < it.parent->shards) {
+        pthread_rwlock_unlock(&it.parent->shard[it.shard].lock);
     }
 
     return stop;
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Histogram.h>
+
+void
+CD_HistogramClear (CDHistogram* self)
+{
+    assert(self);
+
+    memset(self, 0, sizeof(CDHistogram));
+}
+
+void
+CD_HistogramAdd (CDHistogram* self, uint64_t nanoseconds)
+{
+    uint64_t microseconds = nanoseconds / 1000;
+    int      index        = 0;
+
+    assert(self);
+
+    if (microseconds > 1) {
+        index = 63 - __builtin_clzll(microseconds);
+
+        if (index >= CD_HISTOGRAM_BUCKETS) {
+            index = CD_HISTOGRAM_BUCKETS - 1;
+        }
+    }
+
+    // Single writer, the atomic stores only keep the readers from seeing torn values
+    __atomic_store_n(&self->bucket[index], self->bucket[index] + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->sum, self->sum + nanoseconds, __ATOMIC_RELAXED);
+    __atomic_store_n(&self->count, self->count + 1, __ATOMIC_RELAXED);
+
+    if (nanoseconds > self->max) {
+        __atomic_store_n(&self->max, nanoseconds, __ATOMIC_RELAXED);
+    }
+}
+
+void
+CD_HistogramMerge (CDHistogram* self, CDHistogram* other)
+{
+    uint64_t max = __atomic_load_n(&other->max, __ATOMIC_RELAXED);
+
+    assert(self);
+    assert(other);
+
+    for (int i = 0; i < CD_HISTOGRAM_BUCKETS; i++) {
+        self->bucket[i] += __atomic_load_n(&other->bucket[i], __ATOMIC_RELAXED);
+    }
+
+    self->sum   += __atomic_load_n(&other->sum, __ATOMIC_RELAXED);
+    self->count += __atomic_load_n(&other->count, __ATOMIC_RELAXED);
+
+    if (max > self->max) {
+        self->max = max;
+    }
+}
+
+uint64_t
+CD_HistogramPercentile (CDHistogram* self, double percentile)
+{
+    uint64_t total = 0;
+    uint64_t seen  = 0;
+    uint64_t rank;
+
+    assert(self);
+
+    for (int i = 0; i < CD_HISTOGRAM_BUCKETS; i++) {
+        total += self->bucket[i];
+    }
+
+    if (total == 0) {
+        return 0;
+    }
+
+    rank = (uint64_t) (total * percentile / 100.0);
+
+    if (rank >= total) {
+        rank = total - 1;
+    }
+
+    for (int i = 0; i < CD_HISTOGRAM_BUCKETS; i++) {
+        seen += self->bucket[i];
+
+        if (seen > rank) {
+            if (i == CD_HISTOGRAM_BUCKETS - 1) {
+                return self->max;
+            }
+
+            return (2ULL << i) * 1000;
+        }
+    }
+
+    return self->max;
+}
+
+uint64_t
+CD_HistogramAverage (CDHistogram* self)
+{
+    assert(self);
+
+    return self->count ? self->sum / self->count : 0;
+}
@@ -25,14 +25,18 @@
 
 #include <craftd/Job.h>
 
+static CDPool cd_JobPool = CD_POOL_INITIALIZER("CDJob", sizeof(CDJob));
+
 CDJob*
 CD_CreateJob (CDJobType type, CDPointer data)
 {
-    CDJob* self = CD_malloc(sizeof(CDJob));
+    CDJob* self = CD_PoolAlloc(&cd_JobPool);
 
     self->type     = type;
     self->data     = data;
+    self->priority = CDJobNormal;
     self->external = false;
+    self->queued   = 0;
 
     return self;
 }
@@ -40,11 +44,13 @@ CD_CreateJob (CDJobType type, CDPointer data)
 CDJob*
 CD_CreateExternalJob (CDJobType type, CDPointer data)
 {
-    CDJob* self = CD_malloc(sizeof(CDJob));
+    CDJob* self = CD_PoolAlloc(&cd_JobPool);
 
     self->type     = type;
     self->data     = data;
+    self->priority = CDJobNormal;
     self->external = true;
+    self->queued   = 0;
 
     return self;
 }
@@ -55,10 +61,15 @@ CD_DestroyJob (CDJob* self)
     assert(self);
 
     if (!self->external && self->data) {
-        CD_free((void*) self->data);
+        if (self->type == CDClientProcessJob) {
+            CD_PoolsFree((void*) self->data);
+        }
+        else {
+            CD_free((void*) self->data);
+        }
     }
 
-    CD_free(self);
+    CD_PoolFree(&cd_JobPool, self);
 }
 
 CDPointer
@@ -68,7 +79,7 @@ CD_DestroyJobKeepData (CDJob* self)
 
     CDPointer result = self->data;
 
-    CD_free(self);
+    CD_PoolFree(&cd_JobPool, self);
 
     return result;
 }
@@ -85,12 +96,14 @@ CD_CreateCustomJob (CDCustomJobCallback callback, CDPointer data)
 }
 
 CDClientProcessJobData*
-CD_CreateClientProcessJob (CDClient* client, void* packet)
+CD_CreateClientProcessJob (CDClient* client, void** packets, size_t length)
 {
-    CDClientProcessJobData* self = CD_malloc(sizeof(CDClientProcessJobData));
+    CDClientProcessJobData* self = CD_PoolsAlloc(sizeof(CDClientProcessJobData) + sizeof(void*) * length);
 
     self->client = client;
-    self->packet = packet;
+    self->length = length;
+
+    memcpy(self->packets, packets, sizeof(void*) * length);
 
     return self;
 }
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Lane.h>
+
+CDLane*
+CD_CreateLane (void)
+{
+    CDLane* self = CD_malloc(sizeof(CDLane));
+
+    self->items     = CD_CreateListWith(CDListLocked);
+    self->length    = 0;
+    self->scheduled = 0;
+
+    return self;
+}
+
+void
+CD_DestroyLane (CDLane* self)
+{
+    assert(self);
+
+    CD_DestroyList(self->items);
+
+    CD_free(self);
+}
+
+size_t
+CD_LaneLength (CDLane* self)
+{
+    assert(self);
+
+    return __atomic_load_n(&self->length, __ATOMIC_ACQUIRE);
+}
+
+bool
+CD_LanePush (CDLane* self, CDPointer data)
+{
+    assert(self);
+    assert(data);
+
+    // Counted first so the length never goes below the number of values in the list
+    __sync_fetch_and_add(&self->length, 1);
+
+    CD_ListPush(self->items, data);
+
+    return __sync_bool_compare_and_swap(&self->scheduled, 0, 1);
+}
+
+CDPointer
+CD_LaneShift (CDLane* self)
+{
+    assert(self);
+
+    CDPointer result = CD_ListShift(self->items);
+
+    if (result) {
+        __sync_fetch_and_sub(&self->length, 1);
+    }
+
+    return result;
+}
+
+bool
+CD_LaneFinish (CDLane* self)
+{
+    assert(self);
+
+    __atomic_store_n(&self->scheduled, 0, __ATOMIC_SEQ_CST);
+
+    // A push between the last shift and the store above saw the Lane as scheduled
+    if (__atomic_load_n(&self->length, __ATOMIC_SEQ_CST) > 0 && __sync_bool_compare_and_swap(&self->scheduled, 0, 1)) {
+        return false;
+    }
+
+    return true;
+}
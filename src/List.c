@@ -26,6 +26,8 @@
 #include <craftd/common.h>
 #include <craftd/List.h>
 
+#define CD_LIST_MINIMUM 8
+
 static
 int8_t
 cd_ListCompare (CDPointer a, CDPointer b)
@@ -41,129 +43,174 @@ cd_ListCompare (CDPointer a, CDPointer b)
     }
 }
 
-static
-CDListItem*
-cd_ListCreateItem (CDPointer data)
+static inline
+void
+cd_ListReadLock (CDList* self)
 {
-    CDListItem* item = (CDListItem*) CD_malloc(sizeof(CDListItem));
+    if (self->flags & CDListLocked) {
+        pthread_rwlock_rdlock(&self->lock);
+    }
+}
 
-    item->next  = NULL;
-    item->prev  = NULL;
-    item->value = data;
+static inline
+void
+cd_ListWriteLock (CDList* self)
+{
+    if (self->flags & CDListLocked) {
+        pthread_rwlock_wrlock(&self->lock);
+    }
+}
 
-    return item;
+static inline
+void
+cd_ListUnlock (CDList* self)
+{
+    if (self->flags & CDListLocked) {
+        pthread_rwlock_unlock(&self->lock);
+    }
 }
 
+/**
+ * Make room for one more value at the end, moving the values back to the
+ * beginning of the array if shifting left at least half of it unused.
+ */
 static
 void
-cd_ListInsertSorted (CDList* self, CDPointer data, CDListCompareCallback callback)
+cd_ListReserve (CDList* self)
 {
-    CDListItem* item = cd_ListCreateItem(data);
+    if (self->start + self->length < self->size) {
+        return;
+    }
 
-    assert(self);
+    if (self->start > 0 && self->start >= self->size / 2) {
+        memmove(self->item, self->item + self->start, sizeof(CDPointer) * self->length);
 
-    if (self->head == NULL) {
-        self->head = item;
-        self->tail = item;
-    }
-    else if (callback(data, self->head->value) <= 0) {
-        item->next       = self->head;
-        self->head->prev = item;
-        self->head       = item;
+        self->start = 0;
     }
     else {
-        CDListItem* walker = self->head;
-
-        while (walker->next) {
-            if (callback(data, walker->next->value) <= 0) {
-                item->next = walker->next;
-                item->prev = walker;
-                walker->next->prev = item;
-                walker->next = item;
-                walker = NULL;
-                break;
-            }
-
-            walker = walker->next;
-        }
-
-        if (walker != NULL) {
-            item->prev = walker;
-            walker->next = item;
-        }
+        self->size = self->size ? self->size * 2 : CD_LIST_MINIMUM;
+        self->item = CD_realloc(self->item, sizeof(CDPointer) * self->size);
     }
-
-    self->changed = true;
 }
 
 static
 void
-cd_ListSortInsert (CDList* self, CDListCompareCallback callback)
+cd_ListInsert (CDList* self, size_t index, CDPointer data)
 {
-    CDListItem* walker = self->head;
+    CDPointer* item;
 
-    self->head = NULL;
-    self->tail = NULL;
+    cd_ListReserve(self);
 
-    while (walker) {
-        CDListItem* toDestroy = walker;
+    item = self->item + self->start;
 
-        cd_ListInsertSorted(self, walker->value, callback);
+    memmove(item + index + 1, item + index, sizeof(CDPointer) * (self->length - index));
 
-        walker = walker->next;
-
-        CD_free(toDestroy);
-    }
+    item[index] = data;
+    self->length++;
 }
 
 static
 CDPointer
-cd_ListDelete (CDList* self, CDPointer data, CDListCompareCallback callback)
+cd_ListRemove (CDList* self, size_t index)
 {
-    CDPointer result = CDNull;
+    CDPointer* item   = self->item + self->start;
+    CDPointer  result = item[index];
 
-    assert(self);
+    if (index == 0) {
+        self->start++;
+    }
+    else {
+        memmove(item + index, item + index + 1, sizeof(CDPointer) * (self->length - index - 1));
+    }
 
-    if (!self->head) {
-        return CDNull;
+    if (--self->length == 0) {
+        self->start = 0;
     }
 
-    if (callback(data, self->head->value) == 0) {
-        CDListItem* item = self->head;
-        result           = item->value;
-        self->head       = item->next;
+    return result;
+}
 
-        if (self->head) {
-            self->head->prev = NULL;
+static
+void
+cd_ListInsertSorted (CDList* self, CDPointer data, CDListCompareCallback callback)
+{
+    CDPointer* item  = self->item + self->start;
+    size_t     lower = 0;
+    size_t     upper = self->length;
+
+    // Lands before the first value that isn't lesser, as the linear insert did
+    while (lower < upper) {
+        size_t middle = lower + (upper - lower) / 2;
+
+        if (callback(data, item[middle]) <= 0) {
+            upper = middle;
+        }
+        else {
+            lower = middle + 1;
         }
+    }
+
+    cd_ListInsert(self, lower, data);
+}
 
-        self->changed = true;
+static
+void
+cd_ListSortInsert (CDList* self, CDListCompareCallback callback)
+{
+    CDPointer* item = self->item + self->start;
 
-        CD_free(item);
+    for (size_t i = 1; i < self->length; i++) {
+        CDPointer value = item[i];
+        size_t    j     = i;
+
+        while (j > 0 && callback(value, item[j - 1]) < 0) {
+            item[j] = item[j - 1];
+            j--;
+        }
+
+        item[j] = value;
     }
-    else {
-        CDListItem* item = self->head;
+}
 
-        while (item->next) {
-            if (callback(data, item->next->value) == 0) {
-               CDListItem* toDelete   = item->next;
-                           item->next = toDelete->next;
-                           result     = toDelete->value;
- 
-                if (item->next) {
-                    item->next->prev = item;
-                }
+static
+CDPointer
+cd_ListDelete (CDList* self, CDPointer data, CDListCompareCallback callback)
+{
+    CDPointer* item = self->item + self->start;
+
+    for (size_t i = 0; i < self->length; i++) {
+        if (callback(data, item[i]) == 0) {
+            return cd_ListRemove(self, i);
+        }
+    }
 
-                CD_free(toDelete);
+    return CDNull;
+}
 
-                self->changed = true;
+static
+CDPointer
+cd_ListDeleteAll (CDList* self, CDPointer data, CDListCompareCallback callback)
+{
+    CDPointer* item   = self->item + self->start;
+    CDPointer  result = CDNull;
+    size_t     kept   = 0;
 
-                break;
-            }
-            else {
-                item = item->next;
+    // One sweep, the survivors are packed down as it goes
+    for (size_t i = 0; i < self->length; i++) {
+        if (callback(data, item[i]) == 0) {
+            if (!result) {
+                result = item[i];
             }
         }
+        else {
+            item[kept++] = item[i];
+        }
+    }
+
+    self->length = kept;
+
+    if (self->length == 0) {
+        self->start = 0;
     }
 
     return result;
@@ -172,13 +219,19 @@ cd_ListDelete (CDList* self, CDPointer data, CDListCompareCallback callback)
 CDList*
 CD_CreateList (void)
 {
-    CDList* self = CD_malloc(sizeof(CDList));
+    return CD_CreateListWith(CDListDefault);
+}
 
-    self->head = NULL;
-    self->tail = NULL;
+CDList*
+CD_CreateListWith (CDListFlags flags)
+{
+    CDList* self = CD_malloc(sizeof(CDList));
 
-    self->changed = false;
-    self->length  = 0;
+    self->item   = NULL;
+    self->start  = 0;
+    self->length = 0;
+    self->size   = 0;
+    self->flags  = flags;
 
     if (pthread_rwlock_init(&self->lock, NULL) != 0) {
         CD_abort("pthread rwlock failed to initialize");
@@ -190,14 +243,22 @@ CD_CreateList (void)
 CDList*
 CD_CloneList (CDList* self)
 {
-    CDList* cloned = CD_CreateList();
-
     assert(self);
 
-    CD_LIST_FOREACH(self, it) {
-        CD_ListPush(cloned, CD_ListIteratorValue(it));
+    CDList* cloned = CD_CreateListWith(self->flags);
+
+    cd_ListReadLock(self);
+
+    if (self->length > 0) {
+        cloned->size   = self->length;
+        cloned->length = self->length;
+        cloned->item   = CD_malloc(sizeof(CDPointer) * cloned->size);
+
+        memcpy(cloned->item, self->item + self->start, sizeof(CDPointer) * self->length);
     }
 
+    cd_ListUnlock(self);
+
     return cloned;
 }
 
@@ -206,19 +267,10 @@ CD_DestroyList (CDList* self)
 {
     assert(self);
 
-    // Is this neccesary, only when somebody is still reading/writing but that should already
-    // be stopped before you call this.
-    pthread_rwlock_wrlock(&self->lock);
-
-    while (self->head) {
-        CDListItem* next = self->head->next;
-        CD_free(self->head);
-        self->head = next;
+    if (self->item) {
+        CD_free(self->item);
     }
 
-    self->tail = self->head = NULL;
-
-    pthread_rwlock_unlock(&self->lock);
     pthread_rwlock_destroy(&self->lock);
 
     CD_free(self);
@@ -231,7 +283,7 @@ CD_ListBegin (CDList* self)
 
     assert(self);
 
-    it.raw    = self->head;
+    it.raw    = 0;
     it.parent = self;
 
     return it;
@@ -244,7 +296,7 @@ CD_ListEnd (CDList* self)
 
     assert(self);
 
-    it.raw    = CDNull;
+    it.raw    = self->length;
     it.parent = self;
 
     return it;
@@ -253,8 +305,8 @@ CD_ListEnd (CDList* self)
 CDListIterator
 CD_ListNext (CDListIterator it)
 {
-    if (it.raw != NULL) {
-        it.raw = it.raw->next;
+    if (it.raw < it.parent->length) {
+        it.raw++;
     }
 
     return it;
@@ -263,8 +315,11 @@ CD_ListNext (CDListIterator it)
 CDListIterator
 CD_ListPrevious (CDListIterator it)
 {
-    if (it.raw != NULL) {
-        it.raw = it.raw->prev;
+    if (it.raw > 0 && it.raw <= it.parent->length) {
+        it.raw--;
+    }
+    else {
+        it.raw = it.parent->length;
     }
 
     return it;
@@ -273,24 +328,15 @@ CD_ListPrevious (CDListIterator it)
 size_t
 CD_ListLength (CDList* self)
 {
-    assert(self);
+    size_t result;
 
-    pthread_rwlock_rdlock(&self->lock);
-    if (self->changed) {
-        size_t      result = 0;
-        CDListItem* runner = self->head;
-
-        while (runner) {
-            result++;
-            runner = runner->next;
-        }
+    assert(self);
 
-        self->length  = result;
-        self->changed = false;
-    }
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListReadLock(self);
+    result = self->length;
+    cd_ListUnlock(self);
 
-    return self->length;
+    return result;
 }
 
 bool
@@ -303,11 +349,11 @@ CD_ListIteratorIsEqual (CDListIterator a, CDListIterator b)
 CDPointer
 CD_ListIteratorValue (CDListIterator it)
 {
-    if (it.raw == NULL) {
+    if (it.raw >= it.parent->length) {
       return CDNull;
     }
 
-    return it.raw->value;
+    return it.parent->item[it.parent->start + it.raw];
 }
 
 CDList*
@@ -315,27 +361,13 @@ CD_ListPush (CDList* self, CDPointer data)
 {
     assert(self);
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
-    CDListItem* item = (CDListItem*) CD_malloc(sizeof(CDListItem));
+    cd_ListReserve(self);
 
-    item->next  = NULL;
-    item->prev  = NULL;
-    item->value = data;
+    self->item[self->start + self->length++] = data;
 
-    if (self->head == NULL) {
-        self->head = item;
-        self->tail = item;
-    }
-    else {
-        item->prev       = self->tail;
-        self->tail->next = item;
-        self->tail       = item;
-    }
-
-    self->changed  = true;
-
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return self;
 }
@@ -359,11 +391,11 @@ CD_ListSortedPush (CDList* self, CDPointer data, CDListCompareCallback callback)
     assert(self);
     assert(callback);
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
     cd_ListInsertSorted(self, data, callback);
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return self;
 }
@@ -375,17 +407,13 @@ CD_ListShift (CDList* self)
 
     assert(self);
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
-    if (self->head == NULL) {
-        result = CDNull;
-    }
-    else {
-        result = cd_ListDelete(self, self->head->value, cd_ListCompare);
+    if (self->length > 0) {
+        result = cd_ListRemove(self, 0);
     }
-    self->changed = true;
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -397,13 +425,13 @@ CD_ListFirst (CDList* self)
 
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
+    cd_ListReadLock(self);
 
-    if (self->head) {
-        result = self->head->value;
+    if (self->length > 0) {
+        result = self->item[self->start];
     }
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -415,13 +443,13 @@ CD_ListLast (CDList* self)
 
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
+    cd_ListReadLock(self);
 
-    if (self->tail) {
-      result = self->tail->value;
+    if (self->length > 0) {
+      result = self->item[self->start + self->length - 1];
     }
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -429,7 +457,7 @@ CD_ListLast (CDList* self)
 CDList *
 CD_ListSort (CDList* self, CDListSortAlgorithm algorithm, CDListCompareCallback callback)
 {
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
     switch (algorithm) {
         case CDSortInsert: {
@@ -437,7 +465,7 @@ CD_ListSort (CDList* self, CDListSortAlgorithm algorithm, CDListCompareCallback
         } break;
     }
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return self;
 }
@@ -445,34 +473,26 @@ CD_ListSort (CDList* self, CDListSortAlgorithm algorithm, CDListCompareCallback
 bool
 CD_ListIsEqual (CDList* a, CDList* b, CDListCompareCallback callback)
 {
-    if (CD_ListLength(a) != CD_ListLength(b)) {
-        return false;
-    }
-
     bool result = true;
 
-    pthread_rwlock_rdlock(&a->lock);
-    pthread_rwlock_rdlock(&b->lock);
-
-    CDListIterator aIterator = CD_ListBegin(a);
-    CDListIterator aEnd      = CD_ListEnd(a);
+    cd_ListReadLock(a);
+    cd_ListReadLock(b);
 
-    CDListIterator bIterator = CD_ListBegin(b);
-    CDListIterator bEnd      = CD_ListEnd(b);
+    if (a->length != b->length) {
+        result = false;
+        goto end;
+    }
 
-    while (!CD_ListIteratorIsEqual(aIterator, aEnd) && !CD_ListIteratorIsEqual(bIterator, bEnd)) {
-        if (callback(CD_ListIteratorValue(aIterator), CD_ListIteratorValue(bIterator)) != 0) {
+    for (size_t i = 0; i < a->length; i++) {
+        if (callback(a->item[a->start + i], b->item[b->start + i]) != 0) {
             result = false;
             goto end;
         }
-
-        aIterator = CD_ListNext(aIterator);
-        bIterator = CD_ListNext(bIterator);
     }
 
     end: {
-        pthread_rwlock_unlock(&b->lock);
-        pthread_rwlock_unlock(&a->lock);
+        cd_ListUnlock(b);
+        cd_ListUnlock(a);
 
         return result;
     }
@@ -486,11 +506,11 @@ CD_ListDelete (CDList* self, CDPointer data)
     assert(self);
     assert(data);
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
     result = cd_ListDelete(self, data, cd_ListCompare);
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -503,11 +523,11 @@ CD_ListDeleteIf (CDList* self, CDPointer data, CDListCompareCallback callback)
     assert(self);
     assert(data);
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
     result = cd_ListDelete(self, data, callback);
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -518,17 +538,11 @@ CD_ListDeleteAll (CDList* self, CDPointer data)
 {
     CDPointer result = CDNull;
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
-    result = cd_ListDelete(self, data, cd_ListCompare);
-
-    if (result) {
-        while (cd_ListDelete(self, data, cd_ListCompare) != CDNull ) {
-            continue;
-        }
-    }
+    result = cd_ListDeleteAll(self, data, cd_ListCompare);
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -538,45 +552,36 @@ CD_ListDeleteAllIf (CDList* self, CDPointer data, CDListCompareCallback callback
 {
     CDPointer result = CDNull;
 
-    pthread_rwlock_wrlock(&self->lock);
-
-    result = cd_ListDelete(self, data, callback);
+    cd_ListWriteLock(self);
 
-    if (result) {
-        while (cd_ListDelete(self, data, callback) != CDNull ) {
-            continue;
-        }
-    }
+    result = cd_ListDeleteAll(self, data, callback);
 
-    pthread_rwlock_unlock(&self->lock);
+    cd_ListUnlock(self);
 
     return result;
 }
 
-
-// TODO: This doesn't work as it should.
 CDPointer*
 CD_ListClear (CDList* self)
 {
-    CDPointer* result = (CDPointer*) CD_malloc(sizeof(CDPointer) * (CD_ListLength(self) + 1));
-    size_t     i      = 0;
+    CDPointer* result;
 
     assert(self);
-    assert(result);
 
-    pthread_rwlock_wrlock(&self->lock);
+    cd_ListWriteLock(self);
 
-    while (self->head) {
-        CDPointer value = result[i++] = self->head->value;
+    result = (CDPointer*) CD_malloc(sizeof(CDPointer) * (self->length + 1));
 
-        while ((value = cd_ListDelete(self, value, cd_ListCompare)) != CDNull ) {
-            continue;
-        }
+    if (self->length > 0) {
+        memcpy(result, self->item + self->start, sizeof(CDPointer) * self->length);
     }
 
-    pthread_rwlock_unlock(&self->lock);
+    result[self->length] = CDNull;
+
+    self->start  = 0;
+    self->length = 0;
 
-    result[i] = CDNull;
+    cd_ListUnlock(self);
 
     return result;
 }
@@ -586,7 +591,7 @@ CD_ListStartIterating (CDList* self)
 {
     assert(self);
 
-    pthread_rwlock_rdlock(&self->lock);
+    cd_ListReadLock(self);
 
     return true;
 }
@@ -597,7 +602,7 @@ CD_ListStopIterating (CDList* self, bool stop)
     assert(self);
 
     if (!stop) {
-        pthread_rwlock_unlock(&self->lock);
+        cd_ListUnlock(self);
     }
 
     return stop;
@@ -610,14 +615,17 @@ CD_ListContains (CDList* self, CDPointer data)
 
     assert(self);
 
-    CD_LIST_FOREACH(self, it) {
-        if (CD_ListIteratorValue(it) == data) {
-            result = true;
+    cd_ListReadLock(self);
 
-            CD_LIST_BREAK(self);
+    for (CDPointer* item = self->item + self->start, *end = item + self->length; item < end; item++) {
+        if (*item == data) {
+            result = true;
+            break;
         }
     }
 
+    cd_ListUnlock(self);
+
     return result;
 }
 
@@ -628,13 +636,16 @@ CD_ListContainsIf (CDList* self, CDPointer data, CDListCompareCallback callback)
 
     assert(self);
 
-    CD_LIST_FOREACH(self, it) {
-        if (callback(data, CD_ListIteratorValue(it)) == 0) {
-            result = true;
+    cd_ListReadLock(self);
 
-            CD_LIST_BREAK(self);
+    for (size_t i = 0; i < self->length; i++) {
+        if (callback(data, self->item[self->start + i]) == 0) {
+            result = true;
+            break;
         }
     }
 
+    cd_ListUnlock(self);
+
     return result;
 }
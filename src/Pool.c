@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Pool.h>
+
+typedef struct _CDPoolCache {
+    CDPoolObject* head;
+    size_t        length;
+    uint64_t      hits;
+} CDPoolCache;
+
+static __thread CDPoolCache cd_PoolCaches[CD_POOL_MAX];
+
+static CDPool*         cd_Pools[CD_POOL_MAX];
+static size_t          cd_PoolsLength = 0;
+static pthread_mutex_t cd_PoolsLock   = PTHREAD_MUTEX_INITIALIZER;
+
+static CDPool cd_PoolClasses[] = {
+    CD_POOL_INITIALIZER("16 bytes",  16),
+    CD_POOL_INITIALIZER("32 bytes",  32),
+    CD_POOL_INITIALIZER("64 bytes",  64),
+    CD_POOL_INITIALIZER("128 bytes", 128),
+    CD_POOL_INITIALIZER("256 bytes", 256)
+};
+
+#define CD_POOL_CLASSES (sizeof(cd_PoolClasses) / sizeof(CDPool))
+
+// Keeps the objects after it aligned for any scalar they might hold
+typedef union _CDPoolHeader {
+    size_t  index;
+    double  d;
+    int64_t i;
+    void*   p;
+} CDPoolHeader;
+
+static
+CDPoolCache*
+cd_PoolCache (CDPool* self)
+{
+    int index = __atomic_load_n(&self->index, __ATOMIC_ACQUIRE);
+
+    if (index == 0) {
+        pthread_mutex_lock(&cd_PoolsLock);
+
+        if ((index = self->index) == 0) {
+            if (cd_PoolsLength >= CD_POOL_MAX) {
+                CD_abort("too many pools in use");
+            }
+
+            cd_Pools[cd_PoolsLength] = self;
+            index                    = cd_PoolsLength + 1;
+
+            __atomic_store_n(&cd_PoolsLength, index, __ATOMIC_RELEASE);
+            __atomic_store_n(&self->index, index, __ATOMIC_RELEASE);
+        }
+
+        pthread_mutex_unlock(&cd_PoolsLock);
+    }
+
+    return &cd_PoolCaches[index - 1];
+}
+
+static
+void
+cd_PoolSpill (CDPool* self, CDPoolCache* cache, size_t length)
+{
+    CDPoolObject* magazine = cache->head;
+    CDPoolObject* tail     = magazine;
+
+    for (size_t i = 1; i < length; i++) {
+        tail = tail->next;
+    }
+
+    cache->head    = tail->next;
+    cache->length -= length;
+    tail->next     = NULL;
+
+    pthread_mutex_lock(&self->lock);
+    magazine->magazine     = self->depot.magazines;
+    self->depot.magazines  = magazine;
+    self->depot.length    += 1;
+    self->stats.hits      += cache->hits;
+    pthread_mutex_unlock(&self->lock);
+
+    cache->hits = 0;
+}
+
+void*
+CD_PoolAlloc (CDPool* self)
+{
+    CDPoolCache*  cache = cd_PoolCache(self);
+    CDPoolObject* result;
+
+    if (!cache->head) {
+        pthread_mutex_lock(&self->lock);
+        if ((result = self->depot.magazines)) {
+            self->depot.magazines = result->magazine;
+            self->depot.length   -= 1;
+        }
+        else {
+            self->stats.misses++;
+        }
+        self->stats.hits += cache->hits;
+        pthread_mutex_unlock(&self->lock);
+
+        cache->hits = 0;
+
+        if (!result) {
+            if (!self->refill) {
+                return CD_malloc(self->size);
+            }
+
+            if (!(result = self->refill(self))) {
+                return NULL;
+            }
+        }
+
+        for (CDPoolObject* object = result; object; object = object->next) {
+            cache->length++;
+        }
+
+        cache->head = result;
+    }
+
+    result      = cache->head;
+    cache->head = result->next;
+    cache->length--;
+    cache->hits++;
+
+    return result;
+}
+
+void
+CD_PoolFree (CDPool* self, void* data)
+{
+    CDPoolCache*  cache  = cd_PoolCache(self);
+    CDPoolObject* object = data;
+
+    if (!data) {
+        return;
+    }
+
+    object->next = cache->head;
+    cache->head  = object;
+    cache->length++;
+
+    if (cache->length > CD_POOL_CACHE) {
+        cd_PoolSpill(self, cache, CD_POOL_CACHE / 2);
+    }
+}
+
+void*
+CD_PoolsAlloc (size_t size)
+{
+    CDPoolHeader* header;
+
+    for (size_t i = 0; i < CD_POOL_CLASSES; i++) {
+        if (size + sizeof(CDPoolHeader) <= cd_PoolClasses[i].size) {
+            header        = CD_PoolAlloc(&cd_PoolClasses[i]);
+            header->index = i;
+
+            return header + 1;
+        }
+    }
+
+    header        = CD_malloc(sizeof(CDPoolHeader) + size);
+    header->index = CD_POOL_CLASSES;
+
+    return header + 1;
+}
+
+void
+CD_PoolsFree (void* data)
+{
+    CDPoolHeader* header;
+
+    if (!data) {
+        return;
+    }
+
+    header = ((CDPoolHeader*) data) - 1;
+
+    if (header->index < CD_POOL_CLASSES) {
+        CD_PoolFree(&cd_PoolClasses[header->index], header);
+    }
+    else {
+        CD_free(header);
+    }
+}
+
+void
+CD_PoolsFlush (void)
+{
+    size_t length = __atomic_load_n(&cd_PoolsLength, __ATOMIC_ACQUIRE);
+
+    for (size_t i = 0; i < length; i++) {
+        CDPoolCache* cache = &cd_PoolCaches[i];
+
+        if (cache->length > 0) {
+            cd_PoolSpill(cd_Pools[i], cache, cache->length);
+        }
+    }
+}
+
+size_t
+CD_PoolsLength (void)
+{
+    return __atomic_load_n(&cd_PoolsLength, __ATOMIC_ACQUIRE);
+}
+
+CDPool*
+CD_PoolsGet (size_t index)
+{
+    if (index >= CD_PoolsLength()) {
+        return NULL;
+    }
+
+    return cd_Pools[index];
+}
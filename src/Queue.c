@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Queue.h>
+
+CDQueue*
+CD_CreateQueue (size_t capacity)
+{
+    CDQueue* self = CD_malloc(sizeof(CDQueue));
+    size_t   size = 2;
+
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    self->mask  = size - 1;
+    self->cells = CD_malloc(sizeof(CDQueueCell) * size);
+
+    for (size_t i = 0; i < size; i++) {
+        self->cells[i].sequence = i;
+        self->cells[i].value    = CDNull;
+    }
+
+    self->head = 0;
+    self->tail = 0;
+
+    self->stats.contention = 0;
+    self->stats.full       = 0;
+
+    return self;
+}
+
+void
+CD_DestroyQueue (CDQueue* self)
+{
+    assert(self);
+
+    CD_free(self->cells);
+    CD_free(self);
+}
+
+size_t
+CD_QueueCapacity (CDQueue* self)
+{
+    assert(self);
+
+    return self->mask + 1;
+}
+
+size_t
+CD_QueueLength (CDQueue* self)
+{
+    assert(self);
+
+    size_t tail = __atomic_load_n(&self->tail, __ATOMIC_ACQUIRE);
+    size_t head = __atomic_load_n(&self->head, __ATOMIC_ACQUIRE);
+
+    return (head > tail) ? head - tail : 0;
+}
+
+bool
+CD_QueuePush (CDQueue* self, CDPointer data)
+{
+    assert(self);
+    assert(data);
+
+    size_t       position = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+    CDQueueCell* cell;
+
+    while (true) {
+        cell = &self->cells[position & self->mask];
+
+        size_t   sequence   = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) position;
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&self->head, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+
+            __atomic_fetch_add(&self->stats.contention, 1, __ATOMIC_RELAXED);
+        }
+        else if (difference < 0) {
+            __atomic_fetch_add(&self->stats.full, 1, __ATOMIC_RELAXED);
+
+            return false;
+        }
+        else {
+            __atomic_fetch_add(&self->stats.contention, 1, __ATOMIC_RELAXED);
+
+            position = __atomic_load_n(&self->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->value = data;
+
+    __atomic_store_n(&cell->sequence, position + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+CDPointer
+CD_QueueShift (CDQueue* self)
+{
+    assert(self);
+
+    size_t       position = __atomic_load_n(&self->tail, __ATOMIC_RELAXED);
+    CDQueueCell* cell;
+    CDPointer    result;
+
+    while (true) {
+        cell = &self->cells[position & self->mask];
+
+        size_t   sequence   = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        intptr_t difference = (intptr_t) sequence - (intptr_t) (position + 1);
+
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&self->tail, &position, position + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+
+            __atomic_fetch_add(&self->stats.contention, 1, __ATOMIC_RELAXED);
+        }
+        else if (difference < 0) {
+            return CDNull;
+        }
+        else {
+            __atomic_fetch_add(&self->stats.contention, 1, __ATOMIC_RELAXED);
+
+            position = __atomic_load_n(&self->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    result = cell->value;
+
+    __atomic_store_n(&cell->sequence, position + self->mask + 1, __ATOMIC_RELEASE);
+
+    return result;
+}
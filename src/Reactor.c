@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/Reactor.h>
+#include <craftd/Server.h>
+#include <craftd/Logger.h>
+#include <craftd/Affinity.h>
+
+/* Connections accepted for each readiness notification of a listener */
+#define CD_REACTOR_ACCEPT_BATCH 16
+
+static
+void
+cd_ReactorAccept (evutil_socket_t listener, short event, CDReactor* self)
+{
+    for (int i = 0; i < CD_REACTOR_ACCEPT_BATCH; i++) {
+        struct sockaddr_storage storage;
+        socklen_t               length = sizeof(storage);
+        evutil_socket_t         fd     = accept(listener, (struct sockaddr*) &storage, &length);
+
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR && errno != ECONNABORTED) {
+                SERR(self->server, "accept error: %s", strerror(errno));
+            }
+
+            return;
+        }
+
+        CD_ServerAccept(self->server, self, fd, (struct sockaddr*) &storage, length);
+    }
+}
+
+static
+evutil_socket_t
+cd_ReactorSocket (CDReactor* self, struct sockaddr* address, socklen_t length)
+{
+    CDConfig*       config = self->server->config;
+    evutil_socket_t fd;
+
+    if ((fd = socket(address->sa_family, SOCK_STREAM, 0)) < 0) {
+        SERR(self->server, "could not create socket: %s", strerror(errno));
+
+        return -1;
+    }
+
+    evutil_make_socket_nonblocking(fd);
+
+    #ifndef WIN32
+    DO {
+        int one = 1;
+
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        #ifdef SO_REUSEPORT
+        if (config->cache.connection.reactors > 1) {
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        }
+        #endif
+
+        if (address->sa_family == AF_INET6) {
+            setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &one, sizeof(one));
+        }
+    }
+    #endif
+
+    if (bind(fd, address, length) < 0) {
+        SERR(self->server, "cannot bind: %s", strerror(errno));
+        evutil_closesocket(fd);
+
+        return -1;
+    }
+
+    if (listen(fd, config->cache.connection.backlog) < 0) {
+        SERR(self->server, "listen error: %s", strerror(errno));
+        evutil_closesocket(fd);
+
+        return -1;
+    }
+
+    return fd;
+}
+
+CDReactor*
+CD_CreateReactor (CDServer* server, int id)
+{
+    CDReactor* self = CD_malloc(sizeof(CDReactor));
+
+    self->server = server;
+    self->id     = id;
+    self->thread = 0;
+
+    if ((self->event.base = event_base_new()) == NULL) {
+        CD_abort("could not create reactor %d libevent base", id);
+    }
+
+    self->event.ipv4 = NULL;
+    self->event.ipv6 = NULL;
+
+    self->socket.ipv4 = -1;
+    self->socket.ipv6 = -1;
+
+    return self;
+}
+
+void
+CD_DestroyReactor (CDReactor* self)
+{
+    assert(self);
+
+    if (self->event.ipv4) {
+        event_free(self->event.ipv4);
+    }
+
+    if (self->event.ipv6) {
+        event_free(self->event.ipv6);
+    }
+
+    if (self->socket.ipv4 >= 0) {
+        evutil_closesocket(self->socket.ipv4);
+    }
+
+    if (self->socket.ipv6 >= 0) {
+        evutil_closesocket(self->socket.ipv6);
+    }
+
+    event_base_free(self->event.base);
+
+    CD_free(self);
+}
+
+bool
+CD_ReactorListen (CDReactor* self, CDReactor* shared)
+{
+    assert(self);
+
+    CDConfig* config = self->server->config;
+
+    if (shared) {
+        if (shared->socket.ipv4 >= 0) {
+            self->socket.ipv4 = dup(shared->socket.ipv4);
+        }
+
+        if (shared->socket.ipv6 >= 0) {
+            self->socket.ipv6 = dup(shared->socket.ipv6);
+        }
+    }
+    else {
+        self->socket.ipv4 = cd_ReactorSocket(self, (struct sockaddr*) &config->cache.connection.bind.ipv4,
+            sizeof(config->cache.connection.bind.ipv4));
+
+        self->socket.ipv6 = cd_ReactorSocket(self, (struct sockaddr*) &config->cache.connection.bind.ipv6,
+            sizeof(config->cache.connection.bind.ipv6));
+    }
+
+    if (self->socket.ipv4 >= 0) {
+        self->event.ipv4 = event_new(self->event.base, self->socket.ipv4, EV_READ | EV_PERSIST, (event_callback_fn) cd_ReactorAccept, self);
+
+        event_add(self->event.ipv4, NULL);
+    }
+
+    if (self->socket.ipv6 >= 0) {
+        self->event.ipv6 = event_new(self->event.base, self->socket.ipv6, EV_READ | EV_PERSIST, (event_callback_fn) cd_ReactorAccept, self);
+
+        event_add(self->event.ipv6, NULL);
+    }
+
+    return self->socket.ipv4 >= 0 || self->socket.ipv6 >= 0;
+}
+
+bool
+CD_RunReactor (CDReactor* self)
+{
+    assert(self);
+
+    DO {
+        char name[32];
+
+        snprintf(name, sizeof(name), "reactor %d", self->id);
+
+        CD_AffinityPin(self->server, name, self->server->config->cache.affinity.reactors, self->id);
+    }
+
+    CD_EventDispatch(self->server, "Reactor.start!", self);
+
+    SDEBUG(self->server, "reactor %d started", self->id);
+
+    // 0 when the loop was exited, 1 when it ran out of events, -1 on error
+    bool result = event_base_loop(self->event.base, 0) >= 0;
+
+    CD_EventDispatch(self->server, "Reactor.stopped", self);
+
+    CD_ArenaFlush();
+    CD_PoolsFlush();
+
+    return result;
+}
+
+bool
+CD_StopReactor (CDReactor* self)
+{
+    assert(self);
+
+    return event_base_loopbreak(self->event.base) == 0;
+}
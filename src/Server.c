@@ -28,8 +28,13 @@
 #undef CRAFTD_SERVER_IGNORE_EXTERN
 
 #include <craftd/common.h>
+#include <craftd/Affinity.h>
 #include <signal.h>
 
+#ifndef WIN32
+#include <netinet/tcp.h>
+#endif
+
 CDServer* CDMainServer = NULL;
 
 static
@@ -39,6 +44,23 @@ cd_HandleSignal (evutil_socket_t fd, short what, CDServer* self)
     CD_StopServer(self);
 }
 
+static
+void
+cd_DumpEventProfile (evutil_socket_t fd, short what, CDServer* self)
+{
+    CDString* report = CD_EventProfileReport(self);
+
+    if (!report) {
+        SLOG(self, LOG_NOTICE, "the event profiler is disabled, enable server.stats.events");
+
+        return;
+    }
+
+    SLOG(self, LOG_NOTICE, "event profile:\n%s", CD_StringContent(report));
+
+    CD_DestroyString(report);
+}
+
 CDServer*
 CD_CreateServer (const char* path)
 {
@@ -55,18 +77,40 @@ CD_CreateServer (const char* path)
         return NULL;
     }
 
-    self->event.callbacks = CD_CreateHash();
-    self->event.provided  = CD_CreateHash();
+    self->event.callbacks    = CD_calloc(CD_EVENT_MAX, sizeof(CDEventCallbacks*));
+    self->event.subscribers  = CD_calloc(CD_EVENT_MAX, sizeof(CDEventCallbacks*));
+    self->event.provided     = CD_CreateHash();
+    self->event.hooks.before = 0;
+    self->event.hooks.after  = 0;
+    self->event.profile      = self->config->cache.stats.events ? CD_calloc(CD_EVENT_MAX, sizeof(CDEventStats)) : NULL;
+
+    self->event.async.signatures = CD_calloc(CD_EVENT_MAX, sizeof(CDEventSignature*));
+    self->event.async.lanes      = CD_malloc(CD_EVENT_LANES * sizeof(CDEventLane));
+
+    for (int i = 0; i < CD_EVENT_LANES; i++) {
+        self->event.async.lanes[i].server = self;
+        self->event.async.lanes[i].lane   = CD_CreateLane();
+    }
+
+    self->event.async.pending = 0;
 
-    self->protocol = NULL;
+    pthread_mutex_init(&self->event.lock, NULL);
+    pthread_cond_init(&self->event.async.drained, NULL);
+
+    self->protocol  = NULL;
+    self->admission = CD_CreateAdmission(self);
 
     self->timeloop         = CD_CreateTimeLoop(self);
     self->workers          = CD_CreateWorkers(self);
     self->plugins          = CD_CreatePlugins(self);
     self->scriptingEngines = CD_CreateScriptingEngines(self);
 
-    self->clients       = CD_CreateList();
-    self->disconnecting = CD_CreateList();
+    self->clients = CD_CreateListWith(CDListLocked);
+
+    self->reactors.length = 0;
+    self->reactors.item   = NULL;
+
+    self->event.base = NULL;
 
     self->running = false;
 
@@ -79,6 +123,7 @@ CD_CreateServer (const char* path)
     CD_EventProvides(self, "Client.kick",       CD_CreateEventParameters("CDClient", "CDString", NULL));
     CD_EventProvides(self, "Client.disconnect", CD_CreateEventParameters("CDClient", "bool", NULL));
     CD_EventProvides(self, "Client.destroy",    CD_CreateEventParameters("CDClient", NULL));
+    CD_EventProvides(self, "Workers.stats",     CD_CreateEventParameters("CDWorkers", "CDWorkerStats", NULL));
     CD_EventProvides(self, "Server.stop!",      CD_CreateEventParameters(NULL));
     CD_EventProvides(self, "Server.destroy",    CD_CreateEventParameters(NULL));
 
@@ -100,6 +145,9 @@ CD_DestroyServer (CDServer* self)
         CD_ServerKick(self, (CDClient*) CD_ListIteratorValue(it), CD_CreateStringFromCString("shutting down"));
     }
 
+    // The plugins take their parameter types with them
+    CD_EventWaitAsync(self);
+
     if (self->plugins) {
         CD_DestroyPlugins(self->plugins);
     }
@@ -113,24 +161,58 @@ CD_DestroyServer (CDServer* self)
     CD_StopServer(self);
 
     if (self->workers) {
+        CD_StopWorkers(self->workers);
+
+        // Nobody runs the Lanes anymore, what's left on them only has to be released
+        CD_EventDropAsync(self);
+
         CD_DestroyWorkers(self->workers);
     }
 
-    if (self->event.listener) {
-        event_free(self->event.listener);
-        self->event.listener = NULL;
+    for (int i = 0; i < self->reactors.length; i++) {
+        if (self->reactors.item[i]->thread) {
+            pthread_join(self->reactors.item[i]->thread, NULL);
+        }
+
+        CD_DestroyReactor(self->reactors.item[i]);
     }
 
-    if (self->event.base) {
-        event_base_free(self->event.base);
-        self->event.base = NULL;
+    if (self->reactors.item) {
+        CD_free(self->reactors.item);
     }
 
+    self->event.base = NULL;
+
+    CD_DestroyAdmission(self->admission);
+
     if (self->config) {
         CD_DestroyConfig(self->config);
     }
 
-    CD_DestroyHash(self->event.callbacks);
+    for (int i = 0; i < CD_EVENT_MAX; i++) {
+        for (size_t j = 0; self->event.callbacks[i] && j < self->event.callbacks[i]->length; j++) {
+            CD_free(self->event.callbacks[i]->item[j].stats);
+        }
+
+        CD_free(self->event.callbacks[i]);
+        CD_free(self->event.subscribers[i]);
+        CD_free(self->event.async.signatures[i]);
+    }
+
+    for (int i = 0; i < CD_EVENT_LANES; i++) {
+        CD_DestroyLane(self->event.async.lanes[i].lane);
+    }
+
+    CD_free(self->event.callbacks);
+    CD_free(self->event.subscribers);
+    CD_free(self->event.profile);
+    CD_free(self->event.async.signatures);
+    CD_free(self->event.async.lanes);
+
+    // Every thread is gone, nobody can be reading the retired callbacks
+    CD_EpochFlush();
+    pthread_mutex_destroy(&self->event.lock);
+    pthread_cond_destroy(&self->event.async.drained);
 
     CD_HASH_FOREACH(self->event.provided, it) {
         CD_DestroyEventParameters((CDList*) CD_HashIteratorValue(it));
@@ -162,6 +244,51 @@ CD_ServerToString (CDServer* self)
     }
 }
 
+static
+void
+cd_KickCallback (evutil_socket_t fd, short event, CDClient* client)
+{
+    CD_ServerKick(client->server, client, CD_CreateStringFromCString("bad packet"));
+    CD_ClientRelease(client);
+}
+
+/**
+ * Kick a Client from its reactor once the read callback is over.
+ *
+ * The read callback holds the bufferevent lock and the kick sends to the
+ * Client taking its output lock, while Workers take the two the other way
+ * around when they flush.
+ */
+static
+void
+cd_KickDeferred (CDClient* client)
+{
+    struct timeval now = { 0, 0 };
+
+    CD_ClientRetain(client);
+
+    if (event_base_once(client->reactor->event.base, -1, EV_TIMEOUT, (event_callback_fn) cd_KickCallback, client, &now) == 0) {
+        return;
+    }
+
+    // Drop it without the kick message rather than risking the deadlock
+    pthread_rwlock_wrlock(&client->lock.status);
+
+    if (client->status == CDClientDisconnect) {
+        pthread_rwlock_unlock(&client->lock.status);
+        CD_ClientRelease(client);
+
+        return;
+    }
+
+    client->status = CDClientDisconnect;
+
+    pthread_rwlock_unlock(&client->lock.status);
+
+    CD_ClientRelease(client);
+    CD_ClientRelease(client);
+}
+
 static
 void
 cd_ReadCallback (struct bufferevent* event, CDClient* client)
@@ -174,32 +301,74 @@ cd_ReadCallback (struct bufferevent* event, CDClient* client)
       return;
     }
 
-    pthread_rwlock_wrlock(&client->lock.status);
+    if (__atomic_load_n(&client->status, __ATOMIC_ACQUIRE) == CDClientDisconnect) {
+        return;
+    }
+
+    // A kick from a Worker can drop the last reference at any time, so the Client is used with one of its own
+    if (!CD_ClientTryRetain(client)) {
+        return;
+    }
 
     SDEBUG(self, "read data from %s, %d byte/s available", client->ip, CD_BufferLength(client->buffers->input));
 
-    if (client->status == CDClientIdle) {
-        void* packet;
+    DO {
+        size_t limit = self->config->cache.scheduler.lane.packets;
+        void*  packets[limit];
+        size_t length;
+        int    priority;
+
+        // Runs under the bufferevent lock, so packets enter the Lane in the order they were sent.
+        // Parsing stops when the Lane is full, the Worker draining it comes back for the rest.
+        while (CD_LaneLength(client->lane) < (size_t) self->config->cache.scheduler.lane.depth) {
+            priority = CDJobBulk;
+
+            for (length = 0; length < limit; length++) {
+                errno = 0;
+
+                if (!self->protocol->parsable(client->buffers)) {
+                    if (errno == EILSEQ) {
+                        cd_KickDeferred(client);
+                    }
+
+                    break;
+                }
+
+                if (!(packets[length] = self->protocol->parse(client->buffers))) {
+                    break;
+                }
 
-        if (self->protocol->parsable(client->buffers)) {
-            if ((packet = self->protocol->parse(client->buffers))) {
                 CD_BufferReadIn(client->buffers, CDNull, CDNull);
 
-                client->status = CDClientProcess;
-                client->jobs++;
+                // The Job goes with its most urgent packet
+                if (self->protocol->priority) {
+                    int current = self->protocol->priority(packets[length]);
+
+                    if (current < priority) {
+                        priority = current;
+                    }
+                }
+                else {
+                    priority = CDJobNormal;
+                }
+            }
+
+            if (length > 0) {
+                CDJob* job = CD_CreateJob(CDClientProcessJob,
+                    (CDPointer) CD_CreateClientProcessJob(CD_ClientRetain(client), packets, length));
 
-                CD_AddJob(self->workers, CD_CreateJob(CDClientProcessJob,
-                    (CDPointer) CD_CreateClientProcessJob(client, packet)));
+                job->priority = priority;
+
+                CD_ClientAddJob(client, job);
             }
-        }
-        else {
-            if (errno == EILSEQ) {
-                CD_ServerKick(self, client, CD_CreateStringFromCString("bad packet"));
+
+            if (length < limit) {
+                break;
             }
         }
     }
 
-    pthread_rwlock_unlock(&client->lock.status);
+    CD_ClientRelease(client);
 }
 
 static
@@ -214,6 +383,11 @@ cd_ErrorCallback (struct bufferevent* event, short error, CDClient* client)
 
     pthread_rwlock_wrlock(&client->lock.status);
 
+    if (client->status == CDClientDisconnect) {
+        pthread_rwlock_unlock(&client->lock.status);
+        return;
+    }
+
     client->status = CDClientDisconnect;
 
     CDServer* self = client->server;
@@ -229,9 +403,9 @@ cd_ErrorCallback (struct bufferevent* event, short error, CDClient* client)
 
     SLOG(self, LOG_INFO, "%s[%p] errored/disconnected", client->ip, client);
 
-    CD_AddJob(client->server->workers, CD_CreateExternalJob(CDClientDisconnectJob, (CDPointer) client));
-
     pthread_rwlock_unlock(&client->lock.status);
+
+    CD_ClientRelease(client);
 }
 
 static
@@ -254,81 +428,94 @@ cd_LogCallback (int priority, const char* message)
 
 static
 void
-cd_Accept (evutil_socket_t listener, short event, CDServer* self)
+cd_SweepAdmission (evutil_socket_t fd, short event, CDServer* self)
 {
-    CDClient*               client;
-    struct sockaddr_storage storage;
-    socklen_t               length = sizeof(storage);
-    int                     fd     = accept(listener, (struct sockaddr*) &storage, &length);
+    CD_AdmissionSweep(self->admission);
+}
 
-    if (fd < 0) {
-        SERR(self, "accept error: %s", strerror(-fd));
-        return;
-    }
+static
+void
+cd_AutoscaleWorkers (evutil_socket_t fd, short event, CDServer* self)
+{
+    CD_WorkersAutoscale(self->workers);
+}
 
-    if (getpeername(fd, (struct sockaddr*) &storage, &length) < 0) {
-        SERR(self, "could not get peer IP");
-        close(fd);
-        return;
-    }
+static
+void
+cd_DispatchWorkersStats (evutil_socket_t fd, short event, CDServer* self)
+{
+    CDWorkerStats stats;
 
-    client = CD_CreateClient(self);
+    CD_WorkersStats(self->workers, &stats);
 
-    if (storage.ss_family == AF_INET) {
-        evutil_inet_ntop(storage.ss_family, &((struct sockaddr_in*) &storage)->sin_addr, client->ip, sizeof(client->ip));
+    CD_EventDispatch(self, "Workers.stats", self->workers, &stats);
+}
+
+void
+CD_ServerAccept (CDServer* self, CDReactor* reactor, evutil_socket_t fd, struct sockaddr* address, socklen_t length)
+{
+    CDClient* client;
+    char      ip[128];
+
+    if (address->sa_family == AF_INET) {
+        evutil_inet_ntop(address->sa_family, &((struct sockaddr_in*) address)->sin_addr, ip, sizeof(ip));
     }
-    else if (storage.ss_family == AF_INET6) {
-        evutil_inet_ntop(storage.ss_family, &((struct sockaddr_in6*) &storage)->sin6_addr, client->ip, sizeof(client->ip));
+    else if (address->sa_family == AF_INET6) {
+        evutil_inet_ntop(address->sa_family, &((struct sockaddr_in6*) address)->sin6_addr, ip, sizeof(ip));
     }
     else {
         SERR(self, "weird address family");
-        close(fd);
-        CD_DestroyClient(client);
+        evutil_closesocket(fd);
+        return;
     }
 
     if (self->config->cache.game.clients.max > 0) {
         if (CD_ListLength(self->clients) >= self->config->cache.game.clients.max) {
             SERR(self, "too many clients");
-            close(fd);
-            CD_DestroyClient(client);
+            evutil_closesocket(fd);
             return;
         }
     }
 
-    if (self->config->cache.game.clients.simultaneous > 0) {
-        size_t same = 0;
-
-        CD_LIST_FOREACH(self->clients, it) {
-            CDClient* tmp = (CDClient*) CD_ListIteratorValue(it);
-
-            if (CD_CStringIsEqual(tmp->ip, client->ip)) {
-                same++;
-            }
-
-            if (same >= self->config->cache.game.clients.simultaneous) {
-                CD_LIST_BREAK(self->clients);
-            }
+    if (!CD_AdmissionAdmit(self->admission, address)) {
+        if (errno == EMFILE) {
+            SERR(self, "too many connections from %s", ip);
         }
-
-        if (same >= self->config->cache.game.clients.simultaneous) {
-            SERR(self, "too many connections from %s", client->ip);
-            close(fd);
-            CD_DestroyClient(client);
-            return;
+        else {
+            SDEBUG(self, "%s is connecting too fast", ip);
         }
+
+        evutil_closesocket(fd);
+        return;
     }
 
-    client->socket = fd;
+    client = CD_CreateClient(self);
+
+    strncpy(client->ip, ip, sizeof(client->ip));
+    memcpy(&client->address, address, length);
+
+    client->reactor = reactor;
+    client->socket  = fd;
     evutil_make_socket_nonblocking(client->socket);
 
-    client->buffers = CD_WrapBuffers(bufferevent_socket_new(self->event.base, client->socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE));
+    client->buffers = CD_WrapBuffers(bufferevent_socket_new(reactor->event.base, client->socket, BEV_OPT_CLOSE_ON_FREE | BEV_OPT_THREADSAFE));
 
     bufferevent_setcb(client->buffers->raw, (bufferevent_data_cb) cd_ReadCallback, NULL, (bufferevent_event_cb) cd_ErrorCallback, client);
     bufferevent_enable(client->buffers->raw, EV_READ | EV_WRITE);
 
+    if (self->config->cache.connection.output.coalesce) {
+        int one = 1;
+
+        // Output is already batched, so a batch has no reason to wait for Nagle
+        setsockopt(client->socket, IPPROTO_TCP, TCP_NODELAY, (void*) &one, sizeof(one));
+
+        CD_ClientCoalesceOutput(client, reactor->event.base);
+    }
+
     CD_ListPush(self->clients, (CDPointer) client);
 
-    CD_AddJob(self->workers, CD_CreateExternalJob(CDClientConnectJob, (CDPointer) client));
+    // First in the Lane, so no packet is processed before the connection
+    CD_ClientAddJob(client, CD_CreateExternalJob(CDClientConnectJob, (CDPointer) CD_ClientRetain(client)));
 }
 
 bool
@@ -337,55 +524,69 @@ CD_RunServer (CDServer* self)
     event_set_mem_functions(CD_malloc, CD_realloc, CD_free);
     event_set_log_callback(cd_LogCallback);
 
-    if ((self->event.base = event_base_new()) == NULL) {
-        SERR(self, "could not create MC libevent base!");
+    self->reactors.length = self->config->cache.connection.reactors;
+    self->reactors.item   = CD_calloc(self->reactors.length, sizeof(CDReactor*));
 
-        return false;
+    for (int i = 0; i < self->reactors.length; i++) {
+        self->reactors.item[i] = CD_CreateReactor(self, i);
     }
 
+    // The first Reactor runs on the main thread
+    self->event.base = self->reactors.item[0]->event.base;
+
     event_add(evsignal_new(self->event.base, SIGINT, (event_callback_fn) cd_HandleSignal, self), NULL);
+    event_add(evsignal_new(self->event.base, SIGUSR1, (event_callback_fn) cd_DumpEventProfile, self), NULL);
+
+    for (int i = 0; i < self->reactors.length; i++) {
+        #ifdef SO_REUSEPORT
+        CDReactor* shared = NULL;
+        #else
+        CDReactor* shared = (i > 0) ? self->reactors.item[0] : NULL;
+        #endif
 
-    if ((self->socket = socket(PF_INET, SOCK_STREAM, 0)) < 0) {
-        SERR(self, "could not create socket: %s", strerror(-self->socket));
+        if (!CD_ReactorListen(self->reactors.item[i], shared)) {
+            SERR(self, "reactor %d could not listen on port %d", i, self->config->cache.connection.port);
 
-        return false;
+            return false;
+        }
     }
 
-    evutil_make_socket_nonblocking(self->socket);
+    SLOG(self, LOG_INFO, "server listening on port %d with %d reactor/s (%s gameplay)", self->config->cache.connection.port,
+        self->reactors.length, self->config->cache.game.protocol.standard ? "standard" : "custom");
 
-    #ifndef WIN32
-    DO {
-        int one = 1;
-        setsockopt(self->socket, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (self->config->cache.game.clients.max > 0) {
+        SLOG(self, LOG_INFO, "server can host max %d clients", self->config->cache.game.clients.max);
     }
-    #endif
 
-    if ((ERROR(self) = bind(self->socket, (struct sockaddr*) &self->config->cache.connection.bind.ipv4, sizeof(self->config->cache.connection.bind.ipv4))) < 0) {
-        SERR(self, "cannot bind: %s", strerror(ABS(ERROR(self))));
-        return false;
-    }
+    CD_AffinityLogTopology(self);
 
-    if ((ERROR(self) = listen(self->socket, self->config->cache.connection.backlog)) < 0) {
-        SERR(self, "listen error: %s", strerror(ABS(ERROR(self))));
-        return false;
-    }
+    if (self->config->cache.autoscale.enabled) {
+        int workers = self->config->cache.workers;
 
-    SLOG(self, LOG_INFO, "server listening on port %d (%s gameplay)", self->config->cache.connection.port,
-        self->config->cache.game.protocol.standard ? "standard" : "custom");
+        if (workers < self->config->cache.autoscale.min) {
+            workers = self->config->cache.autoscale.min;
+        }
+        else if (workers > self->config->cache.autoscale.max) {
+            workers = self->config->cache.autoscale.max;
+        }
 
-    if (self->config->cache.game.clients.max > 0) {
-        SLOG(self, LOG_INFO, "server can host max %d clients", self->config->cache.game.clients.max);
+        CD_free(CD_SpawnWorkers(self->workers, workers));
+
+        CD_SetInterval(self->timeloop, self->config->cache.autoscale.interval, (event_callback_fn) cd_AutoscaleWorkers, (CDPointer) self);
     }
+    else {
+        CD_free(CD_SpawnWorkers(self->workers, self->config->cache.workers));
+    }
+
+    CD_SetInterval(self->timeloop, 60, (event_callback_fn) cd_SweepAdmission, (CDPointer) self);
 
-    CD_free(CD_SpawnWorkers(self->workers, self->config->cache.workers));
+    if (self->config->cache.stats.interval > 0) {
+        CD_SetInterval(self->timeloop, self->config->cache.stats.interval, (event_callback_fn) cd_DispatchWorkersStats, (CDPointer) self);
+    }
 
     // Start the TimeLoop for timed events
     pthread_create(&self->timeloop->thread, &self->timeloop->attributes, (void *(*)(void *)) CD_RunTimeLoop, self->timeloop);
 
-    self->event.listener = event_new(self->event.base, self->socket, EV_READ | EV_PERSIST, (event_callback_fn) cd_Accept, self);
-
-    event_add(self->event.listener, NULL);
-
     CD_LoadPlugins(self->plugins);
     CD_LoadScriptingEngines(self->scriptingEngines);
 
@@ -393,10 +594,15 @@ CD_RunServer (CDServer* self)
 
     self->running = true;
 
+    for (int i = 1; i < self->reactors.length; i++) {
+        pthread_create(&self->reactors.item[i]->thread, NULL, (void *(*)(void *)) CD_RunReactor, self->reactors.item[i]);
+    }
+
+    // The main thread runs reactor 0, it takes the first CPU of the reactors list
+    CD_AffinityPin(self, "reactor 0", self->config->cache.affinity.reactors, 0);
+
     while (self->running) {
         event_base_loop(self->event.base, 0);
-
-        CD_ServerCleanDisconnects(self);
     }
 
     return true;
@@ -411,6 +617,10 @@ CD_StopServer (CDServer* self)
 
     self->running = false;
 
+    for (int i = 1; i < self->reactors.length; i++) {
+        CD_StopReactor(self->reactors.item[i]);
+    }
+
     CD_ServerFlush(self, true);
 
     CD_EventDispatch(self, "Server.stop!");
@@ -433,22 +643,6 @@ CD_ServerFlush (CDServer* self, bool now)
     }
 }
 
-void
-CD_ServerCleanDisconnects (CDServer* self)
-{
-    if (CD_ListLength(self->disconnecting) > 0) {
-        CD_LIST_FOREACH(self->disconnecting, it) {
-            CDClient* client = (CDClient*) CD_ListDelete(self->clients, CD_ListIteratorValue(it));
-
-            if (client) {
-                CD_DestroyClient(client);
-            }
-        }
-
-        CD_free(CD_ListClear(self->disconnecting));
-    }
-}
-
 void
 CD_ReadFromClient (CDClient* client)
 {
@@ -481,7 +675,7 @@ CD_ServerKick (CDServer* self, CDClient* client, CDString* reason)
 
     client->status = CDClientDisconnect;
 
-    CD_AddJob(client->server->workers, CD_CreateExternalJob(CDClientDisconnectJob, (CDPointer) client));
-
     pthread_rwlock_unlock(&client->lock.status);
+
+    CD_ClientRelease(client);
 }
@@ -8,8 +8,11 @@
  * license.
  */
 
+
 #include <craftd/Set.h>
 
+#define CD_SET_MINIMUM 8
+
 static
 bool
 cmpAtom (CDSet* self, CDPointer a, CDPointer b)
@@ -28,35 +31,187 @@ hashAtom (CDSet* self, CDPointer pointer)
     return (unsigned long) pointer >> 2;
 }
 
+/**
+ * Spread the bits of a hash, both the slot index (low bits) and the control tag
+ * (high bits) come out of it so weak hashes don't cluster.
+ */
+static inline
+uint64_t
+cd_SetMix (uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+
+    return hash;
+}
+
+static inline
+uint64_t
+cd_SetHash (CDSet* self, CDPointer value)
+{
+    if (self->integer) {
+        return cd_SetMix((uint64_t) value);
+    }
+
+    return cd_SetMix(self->hash(self, value));
+}
+
+static inline
+uint8_t
+cd_SetTag (uint64_t hash)
+{
+    return 0x80 | (hash >> 57);
+}
+
+static inline
+bool
+cd_SetEqual (CDSet* self, CDPointer a, CDPointer b)
+{
+    if (self->integer) {
+        return a == b;
+    }
+
+    return self->cmp(self, a, b);
+}
+
+static
+size_t
+cd_SetSizeFor (size_t hint)
+{
+    size_t size = CD_SET_MINIMUM;
+
+    while (size - size / 8 < hint) {
+        size *= 2;
+    }
+
+    return size;
+}
+
+static
+void
+cd_SetAllocate (CDSet* self, size_t size)
+{
+    self->size    = size;
+    self->limit   = size - size / 8;
+    self->members = CD_malloc(size * (sizeof(CDPointer) + 1));
+    self->control = (uint8_t*) (self->members + size);
+
+    memset(self->control, 0, size);
+}
+
+static
+ssize_t
+cd_SetFind (CDSet* self, CDPointer value, uint64_t hash)
+{
+    size_t  mask = self->size - 1;
+    uint8_t tag  = cd_SetTag(hash);
+
+    for (size_t i = hash & mask; self->control[i]; i = (i + 1) & mask) {
+        if (self->control[i] == tag && cd_SetEqual(self, value, self->members[i])) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Put a value known not to be in the Set, there has to be room for it.
+ */
+static
+void
+cd_SetInsert (CDSet* self, CDPointer value, uint64_t hash)
+{
+    size_t mask = self->size - 1;
+    size_t i    = hash & mask;
+
+    while (self->control[i]) {
+        i = (i + 1) & mask;
+    }
+
+    self->control[i] = cd_SetTag(hash);
+    self->members[i] = value;
+    self->length++;
+}
+
+static
+void
+cd_SetGrow (CDSet* self)
+{
+    CDPointer* members = self->members;
+    uint8_t*   control = self->control;
+    size_t     size    = self->size;
+
+    cd_SetAllocate(self, size * 2);
+
+    self->length = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        if (control[i]) {
+            cd_SetInsert(self, members[i], cd_SetHash(self, members[i]));
+        }
+    }
+
+    CD_free(members);
+}
+
+static
+void
+cd_SetAdd (CDSet* self, CDPointer value)
+{
+    if (self->length >= self->limit) {
+        cd_SetGrow(self);
+    }
+
+    cd_SetInsert(self, value, cd_SetHash(self, value));
+}
+
+/**
+ * Empty the given slot, pulling back the members after it that probed past it,
+ * so lookups never need tombstones.
+ */
+static
+void
+cd_SetRemove (CDSet* self, size_t hole)
+{
+    size_t mask = self->size - 1;
+
+    for (size_t i = (hole + 1) & mask; self->control[i]; i = (i + 1) & mask) {
+        size_t home = cd_SetHash(self, self->members[i]) & mask;
+
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            self->control[hole] = self->control[i];
+            self->members[hole] = self->members[i];
+
+            hole = i;
+        }
+    }
+
+    self->control[hole] = 0;
+    self->length--;
+}
+
 CDSet*
 CD_CreateSet (void)
 {
-    return CD_CreateSetWith(4000, NULL, NULL);
+    return CD_CreateSetWith(0, NULL, NULL);
 }
 
 CDSet*
 CD_CreateSetWith (int hint, CDSetCompare cmp, CDSetHash hash)
 {
-    CDSet*     self;
-    static int primes[] = { 509, 1021, 2053, 4093, 8191, 16381, 32771, 65521, INT_MAX };
-    size_t     i;
+    CDSet* self = CD_malloc(sizeof(CDSet));
 
     assert(hint >= 0);
 
-    for (i = 1; primes[i] < hint; i++) {
-        continue;
-    }
-
-    self = CD_malloc(sizeof(CDSet) + primes[i - 1] * sizeof(self->buckets[0]));
-
-    self->size    = primes[i - 1];
     self->cmp     = cmp  ? cmp  : cmpAtom;
     self->hash    = hash ? hash : hashAtom;
-    self->buckets = (CDSetMember**) (self + 1);
+    self->integer = (self->cmp == cmpAtom && self->hash == hashAtom);
 
-    for (size_t i = 0; i < self->size; i++) {
-        self->buckets[i] = NULL;
-    }
+    cd_SetAllocate(self, cd_SetSizeFor(hint));
 
     self->length    = 0;
     self->timestamp = 0;
@@ -67,27 +222,19 @@ CD_CreateSetWith (int hint, CDSetCompare cmp, CDSetHash hash)
 CDSet*
 CD_CloneSet (CDSet* self, int hint)
 {
-    CDSet* cloned = CD_CreateSetWith(hint, self->cmp, self->hash);
-
     assert(self);
-    assert(cloned);
-
-    DO {
-        CDSetMember* oldMember;
-
-        for (size_t i = 0; i < self->size; i++) {
-            for (oldMember = self->buckets[i]; oldMember != NULL; oldMember = oldMember->next) {
-                CDSetMember* newMember = CD_malloc(sizeof(CDSetMember));
-                CDPointer    value     = oldMember->value;
-                int          index     = cloned->hash(cloned, value) % cloned->size;
 
-                assert(newMember);
+    CDSet* cloned = CD_CreateSetWith(CD_Max(hint, self->length), self->cmp, self->hash);
 
-                newMember->value = value;
-                newMember->next  = cloned->buckets[index];
+    if (cloned->size == self->size) {
+        memcpy(cloned->members, self->members, self->size * (sizeof(CDPointer) + 1));
 
-                cloned->buckets[i] = newMember;
-                cloned->length++;
+        cloned->length = self->length;
+    }
+    else {
+        for (size_t i = 0; i < self->size; i++) {
+            if (self->control[i]) {
+                cd_SetAdd(cloned, self->members[i]);
             }
         }
     }
@@ -100,71 +247,40 @@ CD_DestroySet (CDSet* self)
 {
     assert(self);
 
-    if (self->length > 0) {
-        CDSetMember* currentMember;
-        CDSetMember* nextMember;
-
-        for (size_t i = 0; i < self->size; i++) {
-            for (currentMember = self->buckets[i]; currentMember != NULL; currentMember = nextMember) {
-                nextMember = currentMember->next;
-
-                CD_free(currentMember);
-            }
-        }
-    }
-
+    CD_free(self->members);
     CD_free(self);
 }
 
 bool
 CD_SetHas (CDSet* self, CDPointer value)
 {
-    int          index;
-    CDSetMember* member;
-
     assert(self);
-    assert(value);
-
-    index = self->hash(self, value) % self->size;
-
-    for (member = self->buckets[index]; member != NULL; member = member->next) {
-        if (self->cmp(self, value, member->value)) {
-            return true;
-        }
-    }
+    assert(value || self->integer);
 
-    return false;
+    return cd_SetFind(self, value, cd_SetHash(self, value)) >= 0;
 }
 
 void
 CD_SetPut (CDSet* self, CDPointer value)
 {
-    int          index;
-    CDSetMember* member;
+    ssize_t  index;
+    uint64_t hash;
 
     assert(self);
-    assert(value);
+    assert(value || self->integer);
 
-    index = self->hash(self, value) % self->size;
+    hash  = cd_SetHash(self, value);
+    index = cd_SetFind(self, value, hash);
 
-    for (member = self->buckets[index]; member != NULL; member = member->next) {
-        if (self->cmp(self, value, member->value)) {
-            break;
-        }
-    }
-
-    if (member == NULL) {
-        member = CD_malloc(sizeof(CDSetMember));
-
-        assert(member);
-
-        member->value        = value;
-        member->next         = self->buckets[index];
-        self->buckets[index] = member;
-        self->length++;
+    if (index >= 0) {
+        self->members[index] = value;
     }
     else {
-        member->value = value;
+        if (self->length >= self->limit) {
+            cd_SetGrow(self);
+        }
+
+        cd_SetInsert(self, value, hash);
     }
 
     self->timestamp++;
@@ -173,31 +289,24 @@ CD_SetPut (CDSet* self, CDPointer value)
 CDPointer
 CD_SetDelete (CDSet* self, CDPointer value)
 {
-    int           index;
-    CDSetMember** members;
+    ssize_t index;
 
     assert(self);
-    assert(value);
+    assert(value || self->integer);
 
     self->timestamp++;
 
-    index = self->hash(self, value) % self->size;
-
-    for (members = &self->buckets[index]; *members != NULL; members = &(*members)->next) {
-        if (self->cmp(self, value, (*members)->value)) {
-            CDSetMember* member = *members;
-            *members            = member->next;
-            value               = member->value;
+    index = cd_SetFind(self, value, cd_SetHash(self, value));
 
-            CD_free(member);
+    if (index < 0) {
+        return CDNull;
+    }
 
-            self->length--;
+    value = self->members[index];
 
-            return (CDPointer) value;
-        }
-    }
+    cd_SetRemove(self, index);
 
-    return CDNull;
+    return value;
 }
 
 int
@@ -212,7 +321,6 @@ void
 CD_SetMap (CDSet* self, CDSetApply apply, CDPointer context)
 {
     unsigned int stamp;
-    CDSetMember* member;
 
     assert(self);
     assert(apply);
@@ -220,8 +328,8 @@ CD_SetMap (CDSet* self, CDSetApply apply, CDPointer context)
     stamp = self->timestamp;
 
     for (size_t i = 0; i < self->size; i++) {
-        for (member = self->buckets[i]; member != NULL; member = member->next) {
-            apply(self, member->value, context);
+        if (self->control[i]) {
+            apply(self, self->members[i], context);
 
             assert(self->timestamp == stamp);
         }
@@ -231,17 +339,16 @@ CD_SetMap (CDSet* self, CDSetApply apply, CDPointer context)
 CDPointer*
 CD_SetToArray (CDSet* self, CDPointer end)
 {
-    int          j = 0;
-    CDPointer*   array;
-    CDSetMember* member;
+    int        j = 0;
+    CDPointer* array;
 
     assert(self);
 
     array = CD_malloc((self->length + 1) * sizeof(CDPointer));
 
     for (size_t i = 0; i < self->size; i++) {
-        for (member = self->buckets[i]; member != NULL; member = member->next) {
-            array[j++] = member->value;
+        if (self->control[i]) {
+            array[j++] = self->members[i];
         }
     }
 
@@ -256,24 +363,20 @@ CD_SetUnion (CDSet* a, CDSet* b)
     if (a == NULL) {
         assert(b);
 
-        return CD_CloneSet(b, b->size);
+        return CD_CloneSet(b, 0);
     }
 
     if (b == NULL) {
-        return CD_CloneSet(a, a->size);
+        return CD_CloneSet(a, 0);
     }
 
-    CDSet* result = CD_CloneSet(a, CD_Max(a->size, b->size));
+    CDSet* result = CD_CloneSet(a, a->length + b->length);
 
     assert(a->cmp == b->cmp && a->hash == b->hash);
 
-    DO {
-        CDSetMember* member;
-
-        for (size_t i = 0; i < b->size; i++) {
-            for (member = b->buckets[i]; member != NULL; member = member->next) {
-                CD_SetPut(result, member->value);
-            }
+    for (size_t i = 0; i < b->size; i++) {
+        if (b->control[i]) {
+            CD_SetPut(result, b->members[i]);
         }
     }
 
@@ -286,39 +389,24 @@ CD_SetIntersect (CDSet* a, CDSet* b)
     if (a == NULL) {
         assert(b);
 
-        return CD_CreateSetWith(b->size, b->cmp, b->hash);
+        return CD_CreateSetWith(0, b->cmp, b->hash);
     }
 
     if (b == NULL) {
-        return CD_CreateSetWith(a->size, a->cmp, a->hash);
+        return CD_CreateSetWith(0, a->cmp, a->hash);
     }
 
     if (a->length < b->length) {
         return CD_SetIntersect(b, a);
     }
 
-    CDSet* result = CD_CreateSetWith(CD_Min(a->size, b->size), a->cmp, a->hash);
+    CDSet* result = CD_CreateSetWith(b->length, a->cmp, a->hash);
 
     assert(a->cmp == b->cmp && a->hash == b->hash);
 
-    DO {
-        CDSetMember* member;
-
-        for (size_t i = 0; i < b->size; i++) {
-            for (member = b->buckets[i]; member != NULL; member = member->next) {
-                if (CD_SetHas(a, member->value)) {
-                    CDSetMember* current = CD_malloc(sizeof(CDSetMember));
-                    CDPointer    value   = member->value;
-                    int          index   = result->hash(result, value) % result->size;
-
-                    assert(current);
-
-                    current->value     = value;
-                    current->next      = result->buckets[index];
-                    result->buckets[i] = current;
-                    result->length++;
-                }
-            }
+    for (size_t i = 0; i < b->size; i++) {
+        if (b->control[i] && CD_SetHas(a, b->members[i])) {
+            cd_SetAdd(result, b->members[i]);
         }
     }
 
@@ -331,35 +419,20 @@ CD_SetMinus (CDSet* a, CDSet* b)
     if (a == NULL) {
         assert(b);
 
-        return CD_CreateSetWith(b->size, b->cmp, b->hash);
+        return CD_CreateSetWith(0, b->cmp, b->hash);
     }
 
     if (b == NULL) {
-        return CD_CloneSet(a, a->size);
+        return CD_CloneSet(a, 0);
     }
 
-    CDSet* result = CD_CreateSetWith(CD_Min(a->size, b->size), a->cmp, a->hash);
+    CDSet* result = CD_CreateSetWith(a->length, a->cmp, a->hash);
 
     assert(a->cmp == b->cmp && a->hash == b->hash);
 
-    DO {
-        CDSetMember* member;
-
-        for (size_t i = 0; i < a->size; i++) {
-            for (member = a->buckets[i]; member != NULL; member = member->next) {
-                if (!CD_SetHas(b, member->value)) {
-                    CDSetMember* current = CD_malloc(sizeof(CDSetMember));
-                    CDPointer    value   = member->value;
-                    int          index   = result->hash(result, value) % result->size;
-
-                    assert(current);
-
-                    current->value     = value;
-                    current->next      = result->buckets[index];
-                    result->buckets[i] = current;
-                    result->length++;
-                }
-            }
+    for (size_t i = 0; i < a->size; i++) {
+        if (a->control[i] && !CD_SetHas(b, a->members[i])) {
+            cd_SetAdd(result, a->members[i]);
         }
     }
 
@@ -372,14 +445,14 @@ CD_SetDifference (CDSet* a, CDSet* b)
     if (a == NULL) {
         assert(b);
 
-        return CD_CloneSet(b, b->size);
+        return CD_CloneSet(b, 0);
     }
 
     if (b == NULL) {
-        return CD_CloneSet(a, a->size);
+        return CD_CloneSet(a, 0);
     }
 
-    CDSet* result = CD_CreateSetWith(CD_Min(a->size, b->size), a->cmp, a->hash);
+    CDSet* result = CD_CreateSetWith(CD_Max(a->length, b->length), a->cmp, a->hash);
 
     assert(a->cmp == b->cmp && a->hash == b->hash);
 
@@ -389,24 +462,9 @@ CD_SetDifference (CDSet* a, CDSet* b)
         a = sets[i];
         b = sets[i + 1];
 
-        DO {
-            CDSetMember* member;
-
-            for (size_t i = 0; i < b->size; i++) {
-                for (member = b->buckets[i]; member != NULL; member = member->next) {
-                    if (!CD_SetHas(a, member->value)) {
-                        CDSetMember* current = CD_malloc(sizeof(CDSetMember));
-                        CDPointer    value   = member->value;
-                        int          index   = result->hash(result, value) % result->size;
-
-                        assert(current);
-
-                        current->value     = value;
-                        current->next      = result->buckets[index];
-                        result->buckets[i] = current;
-                        result->length++;
-                    }
-                }
+        for (size_t j = 0; j < b->size; j++) {
+            if (b->control[j] && !CD_SetHas(a, b->members[j])) {
+                cd_SetAdd(result, b->members[j]);
             }
         }
     }
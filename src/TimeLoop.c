@@ -24,7 +24,9 @@
  */
 
 #include <craftd/TimeLoop.h>
+#include <craftd/Server.h>
 #include <craftd/Logger.h>
+#include <craftd/Affinity.h>
 
 static
 void
@@ -78,12 +80,17 @@ CD_DestroyTimeLoop (CDTimeLoop* self)
 bool
 CD_RunTimeLoop (CDTimeLoop* self)
 {
+    CD_AffinityPin(self->server, "timeloop", self->server->config->cache.affinity.timeloop, -1);
+
     CD_EventDispatch(self->server, "TimeLoop.start!", self);
 
     bool result = event_base_loop(self->event.base, 0);
 
     CD_EventDispatch(self->server, "TimeLoop.stopped", self);
 
+    CD_ArenaFlush();
+    CD_PoolsFlush();
+
     return result;
 }
 
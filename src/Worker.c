@@ -28,6 +28,13 @@
 #include <craftd/Workers.h>
 #include <craftd/Client.h>
 #include <craftd/Logger.h>
+#include <craftd/Affinity.h>
+
+static __thread CDWorker* cd_CurrentWorker = NULL;
+
+// Only the Worker writes its stats, the atomic stores keep the readers from seeing torn values
+#define CD_WORKER_STAT_ADD(field, value) \
+    __atomic_store_n(&(field), (field) + (value), __ATOMIC_RELAXED)
 
 CDWorker*
 CD_CreateWorker (CDServer* server)
@@ -40,6 +47,10 @@ CD_CreateWorker (CDServer* server)
     self->working = false;
     self->stopped = true;
     self->job     = NULL;
+    self->deque   = NULL;
+    self->seed    = 0;
+
+    self->stats   = NULL;
 
     return self;
 }
@@ -58,148 +69,253 @@ CD_DestroyWorker (CDWorker* self)
         CD_DestroyJob(self->job);
     }
 
+    if (self->deque) {
+        CDJob* job;
+
+        while ((job = (CDJob*) CD_DequePop(self->deque))) {
+            CD_DestroyJob(job);
+        }
+
+        CD_DestroyDeque(self->deque);
+    }
+
+    if (self->stats) {
+        CD_free(self->stats);
+    }
+
     CD_free(self);
 }
 
-bool
-CD_RunWorker (CDWorker* self)
+static
+void
+cd_DestroyProcessJob (CDWorker* self, CDJob* job)
 {
-    assert(self);
+    CDClientProcessJobData* data = (CDClientProcessJobData*) job->data;
 
-    self->stopped = false;
+    for (size_t i = 0; i < data->length; i++) {
+        self->server->protocol->destroy(data->packets[i]);
+    }
 
-    CD_EventDispatch(self->server, "Worker.start!", self);
+    CD_DestroyJob(job);
+}
 
-    SLOG(self->server, LOG_INFO, "worker %d started", self->id);
+static
+void
+cd_RunJob (CDWorker* self, CDJob* job)
+{
+    if (job->type == CDCustomJob) {
+        CDCustomJobData* data = (CDCustomJobData*) job->data;
 
-    while (self->working) {
-        self->job = NULL;
+        data->callback(data->data);
 
-        if (!CD_HasJobs(self->workers)) {
-            pthread_mutex_lock(&self->workers->lock.mutex);
+        CD_DestroyJob(job);
+    }
+    else if (CD_JOB_IS_PLAYER(job)) {
+        CDClient* client;
 
-            SDEBUG(self->server, "worker %d ready", self->id);
+        if (job->type == CDClientProcessJob) {
+            client = ((CDClientProcessJobData*) job->data)->client;
+        }
+        else {
+            client = (CDClient*) job->data;
+        }
+
+        if (!client) {
+            CD_DestroyJob(job);
+            return;
+        }
+
+        if (job->type != CDClientDisconnectJob && __atomic_load_n(&client->status, __ATOMIC_ACQUIRE) == CDClientDisconnect) {
+            if (job->type == CDClientProcessJob) {
+                cd_DestroyProcessJob(self, job);
+            }
+            else {
+                CD_DestroyJob(job);
+            }
 
-            pthread_cond_wait(&self->workers->lock.condition, &self->workers->lock.mutex);
+            CD_ClientRelease(client);
+            return;
+        }
+
+        if (job->type == CDClientConnectJob) {
+            CD_ClientCork(client);
+            CD_EventDispatch(self->server, "Client.connect", client);
+            CD_ClientUncork(client);
+
+            __sync_bool_compare_and_swap(&client->status, CDClientConnect, CDClientIdle);
+
+            CD_DestroyJob(job);
 
-            pthread_mutex_unlock(&self->workers->lock.mutex);
+            CD_ClientRelease(client);
         }
+        else if (job->type == CDClientProcessJob) {
+            CDClientProcessJobData* data = (CDClientProcessJobData*) job->data;
+
+            // The whole burst goes out in a single flush
+            CD_ClientCork(client);
+
+            for (size_t i = 0; i < data->length; i++) {
+                if (i > 0 && __atomic_load_n(&client->status, __ATOMIC_ACQUIRE) == CDClientDisconnect) {
+                    break;
+                }
+
+                CD_EventDispatch(self->server, "Client.process", client, data->packets[i]);
+                CD_EventDispatch(self->server, "Client.processed", client, data->packets[i]);
+            }
+
+            CD_ClientUncork(client);
 
-        if (!self->working) {
-            break;
+            cd_DestroyProcessJob(self, job);
+
+            CD_ClientRelease(client);
         }
+        else if (job->type == CDClientDisconnectJob) {
+            // Queued by the last CD_ClientRelease, no other Job can be holding the Client
+            CD_EventDispatch(self->server, "Client.disconnect", client, (bool) ERROR(client));
 
-        self->job = CD_NextJob(self->workers);
+            CD_ListDelete(self->server->clients, (CDPointer) client);
 
-        if (!self->job) {
-            SDEBUG(self->server, "no jobs for %d :<", self->id);
-            continue;
+            CD_DestroyJob(job);
+
+            CD_DestroyClientDeferred(client);
         }
+    }
+}
 
-        SDEBUG(self->server, "worker %d running", self->id);
+/**
+ * Run a Job and account it, Client Jobs wait from when they were pushed on their Lane
+ */
+static
+void
+cd_RunJobTimed (CDWorker* self, CDJob* job)
+{
+    uint64_t started = CD_MonotonicTime();
+    uint64_t waited  = started - job->queued;
+
+    CD_WORKER_STAT_ADD(self->stats->wait, waited);
+    CD_WORKER_STAT_ADD(self->stats->types[job->type], 1);
+    CD_HistogramAdd(&self->stats->waiting, waited);
+
+    self->job = job;
+    cd_RunJob(self, job);
+    self->job = NULL;
+
+    // Whatever the Job put in the Arena is gone with it
+    CD_ArenaReset();
+
+    uint64_t ran = CD_MonotonicTime() - started;
 
-        if (self->job->type == CDCustomJob) {
-            CDCustomJobData* data = (CDCustomJobData*) self->job->data;
+    CD_WORKER_STAT_ADD(self->stats->busy, ran);
+    CD_WORKER_STAT_ADD(self->stats->jobs, 1);
+    CD_HistogramAdd(&self->stats->running, ran);
+}
+
+static
+void
+cd_RunLane (CDWorker* self, CDClient* client)
+{
+    CDJob*        job;
+    CDJobPriority priority = CDJobNormal;
 
-            data->callback(data->data);
+    for (int done = 0; true; done++) {
+        if (done == self->server->config->cache.scheduler.lane.batch) {
+            // Let the other Clients run, the Lane stays scheduled and the reference goes with it
+            CD_AddJobWithPriority(self->workers, CD_CreateExternalJob(CDClientLaneJob, (CDPointer) client), priority);
 
-            CD_DestroyJob(self->job);
+            return;
         }
-        else if (CD_JOB_IS_PLAYER(self->job)) {
-            CDClient* client;
 
-            if (self->job->type == CDClientProcessJob) {
-                client = ((CDClientProcessJobData*) self->job->data)->client;
-            }
-            else {
-                client = (CDClient*) self->job->data;
+        if (!(job = (CDJob*) CD_LaneShift(client->lane))) {
+            if (CD_LaneFinish(client->lane)) {
+                break;
             }
 
-            if (!client) {
-                CD_DestroyJob(self->job);
-                continue;
-            }
+            continue;
+        }
 
-            pthread_rwlock_rdlock(&client->lock.status);
-            if (client->status == CDClientDisconnect) {
-                if (self->job->type != CDClientDisconnectJob) {
-                    CD_DestroyJob(self->job);
-                    self->job = NULL;
-                    client->jobs--;
-                }
-            }
-            pthread_rwlock_unlock(&client->lock.status);
+        priority = job->priority;
 
-            if (!self->job) {
-                continue;
-            }
+        cd_RunJobTimed(self, job);
+    }
 
-            if (self->job->type == CDClientConnectJob) {
-                CD_EventDispatch(self->server, "Client.connect", client);
+    // Packets left in the input when the Lane got full
+    if (CD_BufferLength(client->buffers->input) > 0) {
+        CD_ReadFromClient(client);
+    }
 
-                pthread_rwlock_wrlock(&client->lock.status);
-                if (client->status != CDClientDisconnect) {
-                    client->status = CDClientIdle;
-                }
-                pthread_rwlock_unlock(&client->lock.status);
+    CD_ClientRelease(client);
+}
 
-                CD_DestroyJob(self->job);
+bool
+CD_RunWorker (CDWorker* self)
+{
+    assert(self);
 
-                if (CD_BufferLength(client->buffers->input) > 0) {
-                    CD_ReadFromClient(client);
-                }
-            }
-            else if (self->job->type == CDClientProcessJob) {
-                CD_EventDispatch(self->server, "Client.process", client,
-                    ((CDClientProcessJobData*) self->job->data)->packet);
+    self->stopped = false;
 
-                CD_EventDispatch(self->server, "Client.processed", client,
-                    ((CDClientProcessJobData*) self->job->data)->packet);
+    cd_CurrentWorker = self;
 
-                pthread_rwlock_wrlock(&client->lock.status);
-                if (client->status != CDClientDisconnect) {
-                    client->status = CDClientIdle;
-                }
+    DO {
+        char name[32];
 
-                client->jobs--;
-                pthread_rwlock_unlock(&client->lock.status);
+        snprintf(name, sizeof(name), "worker %d", self->id);
 
-                CD_DestroyJob(self->job);
+        CD_AffinityPin(self->server, name, self->server->config->cache.affinity.workers, self->id - 1);
+    }
 
-                if (CD_BufferLength(client->buffers->input) > 0) {
-                    CD_ReadFromClient(client);
-                }
-            }
-            else if (self->job->type == CDClientDisconnectJob) {
-                while (true) {
-                    pthread_rwlock_rdlock(&client->lock.status);
+    // Created here after pinning, so the pages are touched by the thread that uses them and land on its NUMA node
+    if (self->server->config->cache.scheduler.stealing && !self->deque) {
+        __atomic_store_n(&self->deque, CD_CreateDeque(256), __ATOMIC_RELEASE);
+    }
 
-                    if (client->jobs < 1) {
-                        pthread_rwlock_unlock(&client->lock.status);
-                        break;
-                    }
+    if (!self->stats) {
+        __atomic_store_n(&self->stats, (CDWorkerStats*) CD_calloc(1, sizeof(CDWorkerStats)), __ATOMIC_RELEASE);
+    }
 
-                    pthread_rwlock_unlock(&client->lock.status);
+    self->seed = ((uint32_t) self->id * 2654435761U) | 1;
 
-                    usleep(1000);
-                }
+    CD_EventDispatch(self->server, "Worker.start!", self);
+
+    SLOG(self->server, LOG_INFO, "worker %d started", self->id);
+
+    while (self->working) {
+        self->job = CD_NextWorkerJob(self->workers, self);
+
+        if (!self->job) {
+            SDEBUG(self->server, "worker %d ready", self->id);
 
-                CD_EventDispatch(self->server, "Client.disconnect", client, (bool) ERROR(client));
+            uint64_t parked = CD_MonotonicTime();
 
-                CD_ListPush(self->server->disconnecting, (CDPointer) client);
+            CD_WorkersWait(self->workers, self);
 
-                CD_ServerFlush(client->server, false);
+            CD_WORKER_STAT_ADD(self->stats->idle, CD_MonotonicTime() - parked);
 
-                CD_DestroyJob(self->job);
-            }
+            continue;
         }
 
-        self->job = NULL;
+        SDEBUG(self->server, "worker %d running", self->id);
+
+        // A Lane is only a way to run the Jobs of a Client in order, its Jobs are accounted one by one
+        if (self->job->type == CDClientLaneJob) {
+            CDJob* lane = self->job;
+
+            self->job = NULL;
+
+            cd_RunLane(self, (CDClient*) CD_DestroyJobKeepData(lane));
+        }
+        else {
+            cd_RunJobTimed(self, self->job);
+        }
     }
 
     CD_EventDispatch(self->server, "Worker.stopped", self);
 
-    self->stopped = true;
+    CD_ArenaFlush();
+    CD_PoolsFlush();
+
+    cd_CurrentWorker = NULL;
+
+    CD_WorkersStopped(self->workers, self);
 
     return true;
 }
@@ -211,17 +327,51 @@ CD_StopWorker (CDWorker* self)
 
     CD_EventDispatch(self->server, "Worker.stop!", self);
 
-    self->working = false;
+    __atomic_store_n(&self->working, false, __ATOMIC_RELEASE);
 
-    pthread_mutex_lock(&self->workers->lock.mutex);
-    pthread_cond_broadcast(&self->workers->lock.condition);
-    pthread_mutex_unlock(&self->workers->lock.mutex);
+    CD_WorkersWake(self->workers, true);
+    CD_WorkersWaitStopped(self->workers, self);
+
+    return true;
+}
 
-    while (!self->stopped) {
-        usleep(1000);
+CDWorker*
+CD_CurrentWorker (void)
+{
+    return cd_CurrentWorker;
+}
 
-        continue;
+void
+CD_WorkerStats (CDWorker* self, CDWorkerStats* stats)
+{
+    assert(self);
+    assert(stats);
+
+    CDWorkerStats* own = __atomic_load_n(&self->stats, __ATOMIC_ACQUIRE);
+
+    // The Worker didn't start yet
+    if (!own) {
+        return;
     }
 
-    return true;
+    CD_WorkerStatsMerge(stats, own);
+}
+
+void
+CD_WorkerStatsMerge (CDWorkerStats* self, CDWorkerStats* other)
+{
+    assert(self);
+    assert(other);
+
+    self->jobs += __atomic_load_n(&other->jobs, __ATOMIC_RELAXED);
+    self->busy += __atomic_load_n(&other->busy, __ATOMIC_RELAXED);
+    self->idle += __atomic_load_n(&other->idle, __ATOMIC_RELAXED);
+    self->wait += __atomic_load_n(&other->wait, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < CD_JOB_TYPES; i++) {
+        self->types[i] += __atomic_load_n(&other->types[i], __ATOMIC_RELAXED);
+    }
+
+    CD_HistogramMerge(&self->waiting, &other->waiting);
+    CD_HistogramMerge(&self->running, &other->running);
 }
@@ -26,6 +26,52 @@
 #include <craftd/Workers.h>
 #include <craftd/Server.h>
 
+#ifdef HAVE_LINUX_FUTEX_H
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+static __thread uint32_t cd_WorkersPick = 0;
+
+static
+void
+cd_WorkersQueuePush (CDWorkersQueue* self, CDJob* job)
+{
+    // Once Jobs overflowed the newer ones line up behind them, or they would jump ahead
+    if (__atomic_load_n(&self->overflow.length, __ATOMIC_ACQUIRE) > 0 || !CD_QueuePush(self->jobs, (CDPointer) job)) {
+        __sync_fetch_and_add(&self->overflow.length, 1);
+
+        CD_ListPush(self->overflow.jobs, (CDPointer) job);
+    }
+}
+
+static
+CDJob*
+cd_WorkersQueueShift (CDWorkersQueue* self)
+{
+    CDJob* job;
+
+    // The queue holds the older Jobs, nothing gets in it while the overflow isn't empty
+    if ((job = (CDJob*) CD_QueueShift(self->jobs))) {
+        return job;
+    }
+
+    if (__atomic_load_n(&self->overflow.length, __ATOMIC_ACQUIRE) > 0) {
+        if ((job = (CDJob*) CD_ListShift(self->overflow.jobs))) {
+            __sync_fetch_and_sub(&self->overflow.length, 1);
+        }
+    }
+
+    return job;
+}
+
+static
+size_t
+cd_WorkersQueueLength (CDWorkersQueue* self)
+{
+    return CD_QueueLength(self->jobs) + __atomic_load_n(&self->overflow.length, __ATOMIC_ACQUIRE);
+}
+
 CDWorkers*
 CD_CreateWorkers (CDServer* server)
 {
@@ -38,16 +84,24 @@ CD_CreateWorkers (CDServer* server)
     self->length = 0;
     self->item   = NULL;
 
-    self->jobs = CD_CreateList();
+    for (int i = 0; i < CD_JOB_PRIORITIES; i++) {
+        self->queues[i].jobs            = CD_CreateQueue(server->config->cache.scheduler.capacity);
+        self->queues[i].overflow.jobs   = CD_CreateListWith(CDListLocked);
+        self->queues[i].overflow.length = 0;
+    }
+
+    self->park.sleeping = 0;
+    self->park.epoch    = 0;
+
+    memset(&self->retired, 0, sizeof(CDWorkerStats));
+
+    memset(&self->autoscale, 0, sizeof(self->autoscale));
 
     if (pthread_attr_init(&self->attributes) != 0) {
         CD_abort("pthread attribute failed to initialize");
     }
 
-    if (pthread_attr_setdetachstate(&self->attributes, PTHREAD_CREATE_DETACHED) != 0) {
-        CD_abort("pthread attribute failed to set in detach state");
-    }
-
+    // Joinable, CD_DestroyWorker joins the thread
     if (pthread_attr_setstacksize(&self->attributes, CD_THREAD_STACK) != 0) {
         CD_abort("pthread attribute failed to set stack size");
     }
@@ -60,6 +114,20 @@ CD_CreateWorkers (CDServer* server)
         CD_abort("pthread cond failed to initialize");
     }
 
+    if (pthread_rwlock_init(&self->lock.workers, NULL) != 0) {
+        CD_abort("pthread rwlock failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.resize, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    if (pthread_cond_init(&self->lock.stopped, NULL) != 0) {
+        CD_abort("pthread cond failed to initialize");
+    }
+
+    self->lock.resizing = false;
+
     return self;
 }
 
@@ -70,21 +138,77 @@ CD_DestroyWorkers (CDWorkers* self)
 
     CD_StopWorkers(self);
 
-    CD_DestroyList(self->jobs);
+    DO {
+        CDJob* job;
+
+        while ((job = CD_NextJob(self))) {
+            CD_DestroyJob(job);
+        }
+    }
+
+    for (int i = 0; i < CD_JOB_PRIORITIES; i++) {
+        CD_DestroyQueue(self->queues[i].jobs);
+        CD_DestroyList(self->queues[i].overflow.jobs);
+    }
 
     pthread_mutex_destroy(&self->lock.mutex);
     pthread_cond_destroy(&self->lock.condition);
+    pthread_rwlock_destroy(&self->lock.workers);
+    pthread_cond_destroy(&self->lock.resize);
+    pthread_cond_destroy(&self->lock.stopped);
 
     CD_free(self);
 }
 
+static
+bool
+cd_LockResize (CDWorkers* self)
+{
+    CDWorker* worker = CD_CurrentWorker();
+
+    pthread_mutex_lock(&self->lock.mutex);
+
+    while (self->lock.resizing) {
+        // Whoever is resizing might be waiting for this Worker to stop
+        if (worker && !__atomic_load_n(&worker->working, __ATOMIC_ACQUIRE)) {
+            pthread_mutex_unlock(&self->lock.mutex);
+
+            return false;
+        }
+
+        pthread_cond_wait(&self->lock.resize, &self->lock.mutex);
+    }
+
+    self->lock.resizing = true;
+
+    pthread_mutex_unlock(&self->lock.mutex);
+
+    return true;
+}
+
+static
+void
+cd_UnlockResize (CDWorkers* self)
+{
+    pthread_mutex_lock(&self->lock.mutex);
+    self->lock.resizing = false;
+    pthread_cond_broadcast(&self->lock.resize);
+    pthread_mutex_unlock(&self->lock.mutex);
+}
+
 void
 CD_StopWorkers (CDWorkers* self)
 {
+    if (!cd_LockResize(self)) {
+        return;
+    }
+
     for (size_t i = 0; i < self->length; i++) {
         CD_StopWorker(self->item[i]);
     }
 
+    pthread_rwlock_wrlock(&self->lock.workers);
+
     for (size_t i = 0; i < self->length; i++) {
         CD_DestroyWorker(self->item[i]);
     }
@@ -93,10 +217,15 @@ CD_StopWorkers (CDWorkers* self)
 
     self->length = 0;
     self->item   = NULL;
+
+    pthread_rwlock_unlock(&self->lock.workers);
+
+    cd_UnlockResize(self);
 }
 
+static
 CDWorker**
-CD_SpawnWorkers (CDWorkers* self, size_t number)
+cd_SpawnWorkers (CDWorkers* self, size_t number)
 {
     CDWorker** result = CD_malloc(sizeof(CDWorker*) * (number + 1));
 
@@ -118,29 +247,92 @@ CD_SpawnWorkers (CDWorkers* self, size_t number)
     return result;
 }
 
+CDWorker**
+CD_SpawnWorkers (CDWorkers* self, size_t number)
+{
+    CDWorker** result;
+
+    if (!cd_LockResize(self)) {
+        return NULL;
+    }
+
+    result = cd_SpawnWorkers(self, number);
+
+    cd_UnlockResize(self);
+
+    return result;
+}
+
+static
 void
-CD_KillWorkers (CDWorkers* self, size_t number)
+cd_RequeueWorkerJobs (CDWorkers* self, CDWorker* worker)
 {
-    assert(self);
+    CDJob* job;
+
+    if (!worker->deque) {
+        return;
+    }
+
+    // The Worker is stopped, the Deque is ours now
+    while ((job = (CDJob*) CD_DequePop(worker->deque))) {
+        cd_WorkersQueuePush(&self->queues[job->priority], job);
+    }
+}
+
+static
+void
+cd_KillWorkers (CDWorkers* self, size_t number)
+{
+    // At least one Worker stays alive
+    if (self->length == 0) {
+        return;
+    }
 
     if (number >= self->length) {
         number = self->length - 1;
     }
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
+    if (number == 0) {
+        return;
+    }
+
+    for (size_t i = self->length - number; i < self->length; i++) {
         CD_StopWorker(self->item[i]);
     }
 
-    pthread_mutex_lock(&self->lock.mutex);
-    pthread_cond_broadcast(&self->lock.condition);
-    pthread_mutex_unlock(&self->lock.mutex);
+    pthread_rwlock_wrlock(&self->lock.workers);
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
-        CD_DestroyWorker(self->item[i]);
+    for (size_t i = self->length - number; i < self->length; i++) {
+        CDWorker* worker = self->item[i];
+
+        cd_RequeueWorkerJobs(self, worker);
+
+        CD_WorkerStats(worker, &self->retired);
+
+        CD_DestroyWorker(worker);
     }
 
     self->length -= number;
     self->item    = CD_realloc(self->item, self->length * sizeof(CDWorker*));
+
+    pthread_rwlock_unlock(&self->lock.workers);
+
+    // Somebody has to pick up the requeued Jobs
+    CD_WorkersWake(self, true);
+}
+
+void
+CD_KillWorkers (CDWorkers* self, size_t number)
+{
+    assert(self);
+
+    if (!cd_LockResize(self)) {
+        return;
+    }
+
+    cd_KillWorkers(self, number);
+
+    cd_UnlockResize(self);
 }
 
 void
@@ -149,30 +341,25 @@ CD_KillWorkersAvoid (CDWorkers* self, size_t number, CDWorker* worker)
     assert(self);
     assert(worker);
 
-    if (number >= self->length) {
-        number = self->length - 1;
+    if (!cd_LockResize(self)) {
+        return;
     }
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
+    // The Workers are killed from the end, so the one to avoid goes first
+    pthread_rwlock_wrlock(&self->lock.workers);
+    for (size_t i = 0; i < self->length; i++) {
         if (self->item[i] == worker) {
-            worker = self->item[0];
-            self->item[0] = self->item[i];
-            self->item[i] = worker;
-        }
+            self->item[i] = self->item[0];
+            self->item[0] = worker;
 
-        CD_StopWorker(self->item[i]);
+            break;
+        }
     }
+    pthread_rwlock_unlock(&self->lock.workers);
 
-    pthread_mutex_lock(&self->lock.mutex);
-    pthread_cond_broadcast(&self->lock.condition);
-    pthread_mutex_unlock(&self->lock.mutex);
+    cd_KillWorkers(self, number);
 
-    for (size_t i = self->length - 1; (self->length - i) < self->length; i--) {
-        CD_DestroyWorker(self->item[i]);
-    }
-
-    self->length -= number;
-    self->item    = CD_realloc(self->item, self->length * sizeof(CDWorker*));
+    cd_UnlockResize(self);
 }
 
 CDWorkers*
@@ -188,33 +375,361 @@ CD_ConcatWorkers (CDWorkers* self, CDWorker** workers, size_t length)
 CDWorkers*
 CD_AppendWorker (CDWorkers* self, CDWorker* worker)
 {
+    pthread_rwlock_wrlock(&self->lock.workers);
+
     self->item = CD_realloc(self->item, sizeof(CDWorker*) * ++self->length);
 
     self->item[self->length - 1] = worker;
 
+    pthread_rwlock_unlock(&self->lock.workers);
+
     return self;
 }
 
 bool
 CD_HasJobs (CDWorkers* self)
 {
-    return CD_ListLength(self->jobs) > 0;
+    bool result = false;
+
+    if (CD_PendingJobs(self) > 0) {
+        return true;
+    }
+
+    if (!self->server->config->cache.scheduler.stealing) {
+        return false;
+    }
+
+    pthread_rwlock_rdlock(&self->lock.workers);
+    for (size_t i = 0; i < self->length && !result; i++) {
+        CDDeque* deque = __atomic_load_n(&self->item[i]->deque, __ATOMIC_ACQUIRE);
+
+        if (deque && CD_DequeLength(deque) > 0) {
+            result = true;
+        }
+    }
+    pthread_rwlock_unlock(&self->lock.workers);
+
+    return result;
 }
 
 void
 CD_AddJob (CDWorkers* self, CDJob* job)
 {
-    pthread_mutex_lock(&self->lock.mutex);
+    CDWorker* worker = CD_CurrentWorker();
 
-    CD_ListPush(self->jobs, (CDPointer) job);
+    job->queued = CD_MonotonicTime();
 
-    pthread_cond_signal(&self->lock.condition);
+    // Jobs queued from inside a Worker stay local, idle Workers will steal them.
+    // The Deque has no priorities, so only Normal Jobs go there.
+    if (job->priority == CDJobNormal && worker && worker->workers == self && worker->deque && worker->working) {
+        CD_DequePush(worker->deque, (CDPointer) job);
 
-    pthread_mutex_unlock(&self->lock.mutex);
+        CD_WorkersWake(self, false);
+
+        return;
+    }
+
+    cd_WorkersQueuePush(&self->queues[job->priority], job);
+
+    CD_WorkersWake(self, false);
+}
+
+void
+CD_AddJobWithPriority (CDWorkers* self, CDJob* job, CDJobPriority priority)
+{
+    assert(priority >= 0 && priority < CD_JOB_PRIORITIES);
+
+    job->priority = priority;
+
+    CD_AddJob(self, job);
+}
+
+size_t
+CD_PendingJobs (CDWorkers* self)
+{
+    size_t result = 0;
+
+    for (int i = 0; i < CD_JOB_PRIORITIES; i++) {
+        result += cd_WorkersQueueLength(&self->queues[i]);
+    }
+
+    return result;
 }
 
 CDJob*
 CD_NextJob (CDWorkers* self)
 {
-    return (CDJob*) CD_ListShift(self->jobs);
+    int*     weights = self->server->config->cache.scheduler.weights;
+    uint32_t total   = weights[CDJobHigh] + weights[CDJobNormal] + weights[CDJobBulk];
+    uint32_t slot    = cd_WorkersPick++ % total;
+    int      first   = 0;
+    CDJob*   job;
+
+    // Every class is preferred for its weight in the picks, so the Bulk Jobs can't starve
+    while (slot >= (uint32_t) weights[first]) {
+        slot -= weights[first];
+        first++;
+    }
+
+    if ((job = cd_WorkersQueueShift(&self->queues[first]))) {
+        return job;
+    }
+
+    for (int i = 0; i < CD_JOB_PRIORITIES; i++) {
+        if (i != first && (job = cd_WorkersQueueShift(&self->queues[i]))) {
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static inline
+uint32_t
+cd_WorkerRandom (CDWorker* worker)
+{
+    worker->seed ^= worker->seed << 13;
+    worker->seed ^= worker->seed >> 17;
+    worker->seed ^= worker->seed << 5;
+
+    return worker->seed;
+}
+
+static
+CDJob*
+cd_StealJob (CDWorkers* self, CDWorker* thief)
+{
+    CDJob* job = NULL;
+
+    pthread_rwlock_rdlock(&self->lock.workers);
+
+    if (self->length > 1) {
+        size_t start = cd_WorkerRandom(thief) % self->length;
+
+        for (size_t i = 0; i < self->length && !job; i++) {
+            CDWorker* victim = self->item[(start + i) % self->length];
+            CDDeque*  deque  = __atomic_load_n(&victim->deque, __ATOMIC_ACQUIRE);
+
+            if (victim == thief || !deque) {
+                continue;
+            }
+
+            job = (CDJob*) CD_DequeSteal(deque);
+        }
+    }
+
+    pthread_rwlock_unlock(&self->lock.workers);
+
+    return job;
+}
+
+CDJob*
+CD_NextWorkerJob (CDWorkers* self, CDWorker* worker)
+{
+    CDJob* job;
+
+    if (!worker->deque) {
+        return CD_NextJob(self);
+    }
+
+    // Look at the shared queue first once in a while, a Worker feeding itself would starve it
+    if ((cd_WorkerRandom(worker) & 63) == 0 && (job = CD_NextJob(self))) {
+        return job;
+    }
+
+    if ((job = (CDJob*) CD_DequePop(worker->deque))) {
+        return job;
+    }
+
+    if ((job = CD_NextJob(self))) {
+        return job;
+    }
+
+    return cd_StealJob(self, worker);
+}
+
+void
+CD_WorkersWait (CDWorkers* self, CDWorker* worker)
+{
+    uint32_t epoch = __atomic_load_n(&self->park.epoch, __ATOMIC_ACQUIRE);
+
+    // Full barrier, a producer either sees us sleeping or we see its Job
+    __sync_fetch_and_add(&self->park.sleeping, 1);
+
+    if (worker->working && !CD_HasJobs(self)) {
+        #ifdef HAVE_LINUX_FUTEX_H
+        syscall(SYS_futex, &self->park.epoch, FUTEX_WAIT_PRIVATE, epoch, NULL, NULL, 0);
+        #else
+        pthread_mutex_lock(&self->lock.mutex);
+        while (__atomic_load_n(&self->park.epoch, __ATOMIC_ACQUIRE) == epoch) {
+            pthread_cond_wait(&self->lock.condition, &self->lock.mutex);
+        }
+        pthread_mutex_unlock(&self->lock.mutex);
+        #endif
+    }
+
+    __sync_fetch_and_sub(&self->park.sleeping, 1);
+}
+
+void
+CD_WorkersWaitStopped (CDWorkers* self, CDWorker* worker)
+{
+    pthread_mutex_lock(&self->lock.mutex);
+
+    // A Worker waiting for the resize lock gives up once it's told to stop
+    pthread_cond_broadcast(&self->lock.resize);
+
+    while (!worker->stopped) {
+        pthread_cond_wait(&self->lock.stopped, &self->lock.mutex);
+    }
+
+    pthread_mutex_unlock(&self->lock.mutex);
+}
+
+void
+CD_WorkersStopped (CDWorkers* self, CDWorker* worker)
+{
+    pthread_mutex_lock(&self->lock.mutex);
+    worker->stopped = true;
+    pthread_cond_broadcast(&self->lock.stopped);
+    pthread_mutex_unlock(&self->lock.mutex);
+}
+
+void
+CD_WorkersWake (CDWorkers* self, bool all)
+{
+    __sync_synchronize();
+
+    if (!all && __atomic_load_n(&self->park.sleeping, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+
+    __sync_fetch_and_add(&self->park.epoch, 1);
+
+    #ifdef HAVE_LINUX_FUTEX_H
+    syscall(SYS_futex, &self->park.epoch, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+    #else
+    pthread_mutex_lock(&self->lock.mutex);
+    if (all) {
+        pthread_cond_broadcast(&self->lock.condition);
+    }
+    else {
+        pthread_cond_signal(&self->lock.condition);
+    }
+    pthread_mutex_unlock(&self->lock.mutex);
+    #endif
+}
+
+void
+CD_WorkersAutoscale (CDWorkers* self)
+{
+    CDConfig*     config = self->server->config;
+    uint64_t      now    = CD_MonotonicTime();
+    CDWorkerStats stats;
+    uint64_t      jobs;
+    uint64_t      busy;
+    uint64_t      wait;
+    size_t        length;
+
+    if (!cd_LockResize(self)) {
+        return;
+    }
+
+    length = CD_WorkersStats(self, &stats);
+    jobs   = stats.jobs;
+    busy   = stats.busy;
+    wait   = stats.wait;
+
+    // The first sample or the pool was resized by somebody else, start over
+    if (self->autoscale.time == 0 || self->autoscale.length != length || length == 0) {
+        self->autoscale.up   = 0;
+        self->autoscale.down = 0;
+
+        goto done;
+    }
+
+    DO {
+        double   utilization = (double) (busy - self->autoscale.busy) / ((double) (now - self->autoscale.time) * length);
+        uint64_t ran         = jobs - self->autoscale.jobs;
+        double   waited      = ran > 0 ? (double) (wait - self->autoscale.wait) / ran / 1000000.0 : 0;
+        size_t   pending     = CD_PendingJobs(self);
+
+        SDEBUG(self->server, "autoscale: %zu workers, %.0f%% utilization, %.2fms wait, %zu pending",
+            length, utilization * 100, waited, pending);
+
+        if ((utilization > config->cache.autoscale.high || waited > config->cache.autoscale.wait) && length < (size_t) config->cache.autoscale.max) {
+            self->autoscale.up++;
+            self->autoscale.down = 0;
+        }
+        else if (utilization < config->cache.autoscale.low && waited <= config->cache.autoscale.wait && pending == 0 && length > (size_t) config->cache.autoscale.min) {
+            self->autoscale.down++;
+            self->autoscale.up = 0;
+        }
+        else {
+            self->autoscale.up   = 0;
+            self->autoscale.down = 0;
+        }
+
+        // Grow fast and shrink one Worker at a time
+        if (self->autoscale.up >= config->cache.autoscale.samples) {
+            size_t number = length / 4 > 0 ? length / 4 : 1;
+
+            if (length + number > (size_t) config->cache.autoscale.max) {
+                number = config->cache.autoscale.max - length;
+            }
+
+            SLOG(self->server, LOG_INFO, "growing the worker pool to %zu (%.0f%% utilization, %.2fms wait)",
+                length + number, utilization * 100, waited);
+
+            CD_free(cd_SpawnWorkers(self, number));
+
+            self->autoscale.up = 0;
+        }
+        else if (self->autoscale.down >= config->cache.autoscale.samples) {
+            SLOG(self->server, LOG_INFO, "shrinking the worker pool to %zu (%.0f%% utilization)",
+                length - 1, utilization * 100);
+
+            cd_KillWorkers(self, 1);
+
+            self->autoscale.down = 0;
+        }
+    }
+
+    done: {
+        self->autoscale.time   = now;
+        self->autoscale.jobs   = jobs;
+        self->autoscale.busy   = busy;
+        self->autoscale.wait   = wait;
+        self->autoscale.length = self->length;
+    }
+
+    cd_UnlockResize(self);
+}
+
+size_t
+CD_WorkersStats (CDWorkers* self, CDWorkerStats* stats)
+{
+    size_t length;
+
+    assert(self);
+    assert(stats);
+
+    memset(stats, 0, sizeof(CDWorkerStats));
+
+    pthread_rwlock_rdlock(&self->lock.workers);
+    CD_WorkerStatsMerge(stats, &self->retired);
+
+    for (size_t i = 0; i < self->length; i++) {
+        CD_WorkerStats(self->item[i], stats);
+    }
+
+    length = self->length;
+    pthread_rwlock_unlock(&self->lock.workers);
+
+    for (int i = 0; i < CD_JOB_PRIORITIES; i++) {
+        stats->queues.contention += __atomic_load_n(&self->queues[i].jobs->stats.contention, __ATOMIC_RELAXED);
+        stats->queues.full       += __atomic_load_n(&self->queues[i].jobs->stats.full, __ATOMIC_RELAXED);
+    }
+
+    return length;
 }
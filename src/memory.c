@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2010-2011 Kevin M. Bowling, <kevin.bowling@kev009.com>, USA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <craftd/common.h>
+
+#include <sys/mman.h>
+
+/**
+ * Address space reserved for the slabs, pages are only backed once touched
+ */
+#if SIZEOF_POINTER == 4
+#   define CD_SLAB_RESERVE (64UL * 1024 * 1024)
+#else
+#   define CD_SLAB_RESERVE (1024UL * 1024 * 1024)
+#endif
+
+/**
+ * Each page holds objects of a single size class
+ */
+#define CD_SLAB_PAGE (64 * 1024)
+
+/**
+ * Objects handed to a thread cache at once when a class runs out
+ */
+#define CD_SLAB_BATCH (CD_POOL_CACHE / 2)
+
+static CDPoolObject* cd_SlabRefill (CDPool* pool);
+
+static CDPool cd_SlabPools[] = {
+    CD_POOL_INITIALIZER_WITH("slab 16 bytes",  16,  cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 32 bytes",  32,  cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 48 bytes",  48,  cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 64 bytes",  64,  cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 96 bytes",  96,  cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 128 bytes", 128, cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 192 bytes", 192, cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 256 bytes", 256, cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 384 bytes", 384, cd_SlabRefill),
+    CD_POOL_INITIALIZER_WITH("slab 512 bytes", 512, cd_SlabRefill)
+};
+
+#define CD_SLAB_CLASSES (sizeof(cd_SlabPools) / sizeof(CDPool))
+
+#define CD_SLAB_LARGEST 512
+
+static struct {
+    char* base;
+    char* end;
+    char* next;
+
+    // Size class of every page and of every size up to CD_SLAB_LARGEST in 16 byte steps
+    uint8_t pages[CD_SLAB_RESERVE / CD_SLAB_PAGE];
+    uint8_t sizes[CD_SLAB_LARGEST / 16 + 1];
+
+    struct {
+        char* cursor;
+        char* limit;
+    } carving[CD_SLAB_CLASSES];
+
+    pthread_mutex_t lock;
+    pthread_once_t  once;
+} cd_Slab = { .lock = PTHREAD_MUTEX_INITIALIZER, .once = PTHREAD_ONCE_INIT };
+
+static
+void
+cd_SlabInitialize (void)
+{
+    void* base = mmap(NULL, CD_SLAB_RESERVE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (base == MAP_FAILED) {
+        return;
+    }
+
+    for (size_t i = 0, class = 0; i <= CD_SLAB_LARGEST / 16; i++) {
+        while (cd_SlabPools[class].size < i * 16) {
+            class++;
+        }
+
+        cd_Slab.sizes[i] = class;
+    }
+
+    cd_Slab.next = base;
+    cd_Slab.end  = (char*) base + CD_SLAB_RESERVE;
+
+    __atomic_store_n(&cd_Slab.base, (char*) base, __ATOMIC_RELEASE);
+}
+
+static inline
+bool
+cd_SlabOwns (void* pointer)
+{
+    char* base = __atomic_load_n(&cd_Slab.base, __ATOMIC_ACQUIRE);
+
+    return base && (char*) pointer >= base && (char*) pointer < cd_Slab.end;
+}
+
+static inline
+CDPool*
+cd_SlabPool (void* pointer)
+{
+    return &cd_SlabPools[cd_Slab.pages[((char*) pointer - cd_Slab.base) / CD_SLAB_PAGE]];
+}
+
+static
+CDPoolObject*
+cd_SlabRefill (CDPool* pool)
+{
+    size_t        class  = pool - cd_SlabPools;
+    CDPoolObject* result = NULL;
+
+    pthread_mutex_lock(&cd_Slab.lock);
+    for (size_t i = 0; i < CD_SLAB_BATCH; i++) {
+        if (!cd_Slab.carving[class].cursor || cd_Slab.carving[class].cursor + pool->size > cd_Slab.carving[class].limit) {
+            if (cd_Slab.next + CD_SLAB_PAGE > cd_Slab.end) {
+                break;
+            }
+
+            cd_Slab.pages[(cd_Slab.next - cd_Slab.base) / CD_SLAB_PAGE] = class;
+
+            cd_Slab.carving[class].cursor = cd_Slab.next;
+            cd_Slab.carving[class].limit  = cd_Slab.next + CD_SLAB_PAGE;
+
+            cd_Slab.next += CD_SLAB_PAGE;
+        }
+
+        CDPoolObject* object = (CDPoolObject*) cd_Slab.carving[class].cursor;
+
+        object->next = result;
+        result       = object;
+
+        cd_Slab.carving[class].cursor += pool->size;
+    }
+    pthread_mutex_unlock(&cd_Slab.lock);
+
+    return result;
+}
+
+static
+void*
+cd_SystemMalloc (size_t size)
+{
+    return malloc(size);
+}
+
+static
+void*
+cd_SlabMalloc (size_t size)
+{
+    void* pointer = NULL;
+
+    if (size <= CD_SLAB_LARGEST) {
+        if (!__atomic_load_n(&cd_Slab.base, __ATOMIC_ACQUIRE)) {
+            pthread_once(&cd_Slab.once, cd_SlabInitialize);
+        }
+
+        if (__atomic_load_n(&cd_Slab.base, __ATOMIC_ACQUIRE)) {
+            pointer = CD_PoolAlloc(&cd_SlabPools[cd_Slab.sizes[(size + 15) / 16]]);
+        }
+    }
+
+    // Too big or out of address space
+    if (!pointer) {
+        pointer = malloc(size);
+    }
+
+    return pointer;
+}
+
+static
+void
+cd_SystemFree (void* pointer)
+{
+    if (cd_SlabOwns(pointer)) {
+        CD_PoolFree(cd_SlabPool(pointer), pointer);
+    }
+    else {
+        free(pointer);
+    }
+}
+
+/**
+ * Move a slab object somewhere with room for size bytes
+ */
+static
+void*
+cd_SlabMove (void* pointer, size_t size, void* (*allocate) (size_t))
+{
+    CDPool* pool = cd_SlabPool(pointer);
+    void*   result;
+
+    if (size <= pool->size) {
+        return pointer;
+    }
+
+    if ((result = allocate(size))) {
+        memcpy(result, pointer, pool->size);
+
+        CD_PoolFree(pool, pointer);
+    }
+
+    return result;
+}
+
+static
+void*
+cd_SystemRealloc (void* pointer, size_t size)
+{
+    if (cd_SlabOwns(pointer)) {
+        return cd_SlabMove(pointer, size, cd_SystemMalloc);
+    }
+
+    return realloc(pointer, size);
+}
+
+static
+void*
+cd_SlabRealloc (void* pointer, size_t size)
+{
+    if (cd_SlabOwns(pointer)) {
+        return cd_SlabMove(pointer, size, cd_SlabMalloc);
+    }
+
+    return realloc(pointer, size);
+}
+
+static CDAllocator cd_SystemAllocator = { "system", cd_SystemMalloc, cd_SystemRealloc, cd_SystemFree };
+static CDAllocator cd_SlabAllocator   = { "slab",   cd_SlabMalloc,   cd_SlabRealloc,   cd_SystemFree };
+
+#ifdef CRAFTD_SLAB
+CDAllocator* CD_Allocator = &cd_SlabAllocator;
+#else
+CDAllocator* CD_Allocator = &cd_SystemAllocator;
+#endif
+
+bool
+CD_UseAllocator (const char* name)
+{
+    assert(name);
+
+    if (CD_CStringIsEqual(name, "system")) {
+        __atomic_store_n(&CD_Allocator, &cd_SystemAllocator, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+    if (CD_CStringIsEqual(name, "slab")) {
+        pthread_once(&cd_Slab.once, cd_SlabInitialize);
+
+        if (!__atomic_load_n(&cd_Slab.base, __ATOMIC_ACQUIRE)) {
+            return false;
+        }
+
+        __atomic_store_n(&CD_Allocator, &cd_SlabAllocator, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+    return false;
+}
@@ -109,31 +109,32 @@ SV_BufferAddBoolean (CDBuffer* self, SVBoolean data)
 void
 SV_BufferAddString (CDBuffer* self, CDString* data)
 {
-    CDString* sanitized = SV_StringSanitize(data);
+    CDArenaMark mark      = CD_ArenaSave();
+    char*       sanitized = CD_ArenaAlloc(CD_StringSize(data) + 1);
+    size_t      length    = SV_StringSanitizeInto(data, sanitized);
 
-    SVShort size = htons(CD_StringSize(sanitized));
+    SVShort size = htons(length);
 
     evbuffer_add(self->raw, &size, SVShortSize);
-    evbuffer_add(self->raw, CD_StringContent(sanitized), CD_StringSize(sanitized));
+    evbuffer_add(self->raw, sanitized, length);
 
-    SV_DestroyString(sanitized);
+    CD_ArenaRestore(mark);
 }
 
 void
 SV_BufferAddString16 (CDBuffer* self, CDString* data)
 {
-    CDString* sanitized = SV_StringSanitize(data);
-
-    SVShort size = htons(CD_StringLength(sanitized));
-
-    evbuffer_add(self->raw, &size, SVShortSize);
-
-    int16_t* ucs2 = CD_alloc(CD_StringLength(sanitized) * sizeof(int16_t));
-
-    for (size_t i = 0; i < CD_StringLength(sanitized); i++) {
-        CDString*   ch    = CD_CharAt(sanitized, i);
-        const char* input = CD_StringContent(ch);
+    CDArenaMark mark      = CD_ArenaSave();
+    char*       sanitized = CD_ArenaAlloc(CD_StringSize(data) + 1);
+    size_t      length    = SV_StringSanitizeInto(data, sanitized);
+    int16_t*    ucs2      = CD_ArenaAlloc(length * sizeof(int16_t));
+    size_t      chars     = 0;
+
+    // Decode in place, the sanitized String is NUL terminated so truncated sequences are caught
+    for (size_t offset = 0; offset < length; chars++) {
+        const char* input = sanitized + offset;
         short       uch   = 0;
+        size_t      size  = CD_UTF8_offset(input, 1);
 
         if ((input[0] & 0x80) == 0x00) {
             uch = input[0];
@@ -158,15 +159,16 @@ SV_BufferAddString16 (CDBuffer* self, CDString* data)
             uch = 0xfffd;
         }
 
-        CD_DestroyString(ch);
-
-        ucs2[i] = htons(uch);
+        ucs2[chars] = htons(uch);
+        offset     += (size > 0) ? size : 1;
     }
 
-    evbuffer_add(self->raw, ucs2, CD_StringLength(sanitized) * sizeof(int16_t));
+    SVShort size = htons(chars);
+
+    evbuffer_add(self->raw, &size, SVShortSize);
+    evbuffer_add(self->raw, ucs2, chars * sizeof(int16_t));
 
-    CD_free(ucs2);
-    CD_DestroyString(sanitized);
+    CD_ArenaRestore(mark);
 }
 
 void
@@ -24,13 +24,16 @@
  */
 
 #include <craftd/Logger.h>
+#include <craftd/Job.h>
 
 #include <craftd/protocols/survival/Packet.h>
 
+static CDPool sv_PacketPool = CD_POOL_INITIALIZER("SVPacket", sizeof(SVPacket));
+
 SVPacket*
 SV_PacketFromBuffers (CDBuffers* buffers)
 {
-    SVPacket* self = CD_malloc(sizeof(SVPacket));
+    SVPacket* self = CD_PoolAlloc(&sv_PacketPool);
 
     assert(self);
 
@@ -51,6 +54,39 @@ SV_PacketFromBuffers (CDBuffers* buffers)
     return self;
 }
 
+int
+SV_PacketPriority (SVPacket* self)
+{
+    assert(self);
+
+    switch (self->type) {
+        // What the player feels as lag
+        case SVKeepAlive:
+        case SVChat:
+        case SVOnGround:
+        case SVPlayerPosition:
+        case SVPlayerLook:
+        case SVPlayerMoveLook:
+        case SVPlayerDigging:
+        case SVPlayerBlockPlacement:
+        case SVHoldChange:
+        case SVAnimation:
+        case SVEntityAction: {
+            return CDJobHigh;
+        }
+
+        // These send the whole surrounding world
+        case SVLogin:
+        case SVRespawn: {
+            return CDJobBulk;
+        }
+
+        default: {
+            return CDJobNormal;
+        }
+    }
+}
+
 void
 SV_DestroyPacket (SVPacket* self)
 {
@@ -58,8 +94,15 @@ SV_DestroyPacket (SVPacket* self)
 
     SV_DestroyPacketData(self);
 
-    CD_free((void*) self->data);
-    CD_free(self);
+    // Requests come from SV_PacketFromBuffers, responses from whoever built them
+    if (self->chain == SVRequest) {
+        CD_PoolsFree((void*) self->data);
+        CD_PoolFree(&sv_PacketPool, self);
+    }
+    else {
+        CD_free((void*) self->data);
+        CD_free(self);
+    }
 }
 
 void
@@ -211,11 +254,11 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
 
     switch (self->type) {
         case SVKeepAlive: {
-            return (CDPointer) CD_malloc(sizeof(SVPacketKeepAlive));
+            return (CDPointer) CD_PoolsAlloc(sizeof(SVPacketKeepAlive));
         }
 
         case SVLogin: {
-            SVPacketLogin* packet = (SVPacketLogin*) CD_malloc(sizeof(SVPacketLogin));
+            SVPacketLogin* packet = (SVPacketLogin*) CD_PoolsAlloc(sizeof(SVPacketLogin));
 
             SV_BufferRemoveFormat(input, "iUlb",
                 &packet->request.version,
@@ -228,7 +271,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVHandshake: {
-            SVPacketHandshake* packet = (SVPacketHandshake*) CD_malloc(sizeof(SVPacketHandshake));
+            SVPacketHandshake* packet = (SVPacketHandshake*) CD_PoolsAlloc(sizeof(SVPacketHandshake));
 
             packet->request.username = SV_BufferRemoveString16(input);
 
@@ -236,7 +279,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVChat: {
-            SVPacketChat* packet = (SVPacketChat*) CD_malloc(sizeof(SVPacketChat));
+            SVPacketChat* packet = (SVPacketChat*) CD_PoolsAlloc(sizeof(SVPacketChat));
 
             packet->request.message = SV_BufferRemoveString16(input);
 
@@ -244,7 +287,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVUseEntity: {
-            SVPacketUseEntity* packet = (SVPacketUseEntity*) CD_malloc(sizeof(SVPacketUseEntity));
+            SVPacketUseEntity* packet = (SVPacketUseEntity*) CD_PoolsAlloc(sizeof(SVPacketUseEntity));
 
             SV_BufferRemoveFormat(input, "iib",
                 &packet->request.user,
@@ -256,11 +299,11 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVRespawn: {
-            return (CDPointer) CD_malloc(sizeof(SVPacketRespawn));
+            return (CDPointer) CD_PoolsAlloc(sizeof(SVPacketRespawn));
         }
 
         case SVOnGround: {
-            SVPacketOnGround* packet = (SVPacketOnGround*) CD_malloc(sizeof(SVPacketOnGround));
+            SVPacketOnGround* packet = (SVPacketOnGround*) CD_PoolsAlloc(sizeof(SVPacketOnGround));
 
             packet->request.onGround = SV_BufferRemoveBoolean(input);
 
@@ -268,7 +311,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerPosition: {
-            SVPacketPlayerPosition* packet = (SVPacketPlayerPosition*) CD_malloc(sizeof(SVPacketPlayerPosition));
+            SVPacketPlayerPosition* packet = (SVPacketPlayerPosition*) CD_PoolsAlloc(sizeof(SVPacketPlayerPosition));
 
             SV_BufferRemoveFormat(input, "ddddb",
                 &packet->request.position.x,
@@ -282,7 +325,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerLook: {
-            SVPacketPlayerLook* packet = (SVPacketPlayerLook*) CD_malloc(sizeof(SVPacketPlayerLook));
+            SVPacketPlayerLook* packet = (SVPacketPlayerLook*) CD_PoolsAlloc(sizeof(SVPacketPlayerLook));
 
             SV_BufferRemoveFormat(input, "ffb",
                 &packet->request.yaw,
@@ -294,7 +337,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerMoveLook: {
-            SVPacketPlayerMoveLook* packet = (SVPacketPlayerMoveLook*) CD_malloc(sizeof(SVPacketPlayerMoveLook));
+            SVPacketPlayerMoveLook* packet = (SVPacketPlayerMoveLook*) CD_PoolsAlloc(sizeof(SVPacketPlayerMoveLook));
 
             SV_BufferRemoveFormat(input, "ddddffb",
                 &packet->request.position.x,
@@ -310,7 +353,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerDigging: {
-            SVPacketPlayerDigging* packet = (SVPacketPlayerDigging*) CD_malloc(sizeof(SVPacketPlayerDigging));
+            SVPacketPlayerDigging* packet = (SVPacketPlayerDigging*) CD_PoolsAlloc(sizeof(SVPacketPlayerDigging));
 
             packet->request.status = SV_BufferRemoveByte(input);
 
@@ -332,7 +375,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVPlayerBlockPlacement: {
-            SVPacketPlayerBlockPlacement* packet = (SVPacketPlayerBlockPlacement*) CD_malloc(sizeof(SVPacketPlayerBlockPlacement));
+            SVPacketPlayerBlockPlacement* packet = (SVPacketPlayerBlockPlacement*) CD_PoolsAlloc(sizeof(SVPacketPlayerBlockPlacement));
 
             SV_BufferRemoveFormat(input, "ibibs",
                 &packet->request.position.x,
@@ -354,7 +397,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVHoldChange: {
-            SVPacketHoldChange* packet = (SVPacketHoldChange*) CD_malloc(sizeof(SVPacketHoldChange));
+            SVPacketHoldChange* packet = (SVPacketHoldChange*) CD_PoolsAlloc(sizeof(SVPacketHoldChange));
 
             packet->request.item.id = SV_BufferRemoveShort(input);
 
@@ -362,7 +405,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVAnimation: {
-            SVPacketAnimation* packet = (SVPacketAnimation*) CD_malloc(sizeof(SVPacketAnimation));
+            SVPacketAnimation* packet = (SVPacketAnimation*) CD_PoolsAlloc(sizeof(SVPacketAnimation));
 
             SV_BufferRemoveFormat(input, "ib",
                 &packet->request.entity.id,
@@ -373,7 +416,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVEntityAction: {
-            SVPacketEntityAction* packet = (SVPacketEntityAction*) CD_malloc(sizeof(SVPacketEntityAction));
+            SVPacketEntityAction* packet = (SVPacketEntityAction*) CD_PoolsAlloc(sizeof(SVPacketEntityAction));
 
             packet->request.entity.id = SV_BufferRemoveInteger(input);
             packet->request.action    = SV_BufferRemoveByte(input);
@@ -382,7 +425,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVEntityMetadata: {
-            SVPacketEntityMetadata* packet = (SVPacketEntityMetadata*) CD_malloc(sizeof(SVPacketEntityMetadata));
+            SVPacketEntityMetadata* packet = (SVPacketEntityMetadata*) CD_PoolsAlloc(sizeof(SVPacketEntityMetadata));
 
             SV_BufferRemoveFormat(input, "iM",
                 &packet->request.entity.id,
@@ -393,7 +436,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVCloseWindow: {
-            SVPacketCloseWindow* packet = (SVPacketCloseWindow*) CD_malloc(sizeof(SVPacketCloseWindow));
+            SVPacketCloseWindow* packet = (SVPacketCloseWindow*) CD_PoolsAlloc(sizeof(SVPacketCloseWindow));
 
             packet->request.id = SV_BufferRemoveByte(input);
 
@@ -401,7 +444,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVWindowClick: {
-            SVPacketWindowClick* packet = (SVPacketWindowClick*) CD_malloc(sizeof(SVPacketWindowClick));
+            SVPacketWindowClick* packet = (SVPacketWindowClick*) CD_PoolsAlloc(sizeof(SVPacketWindowClick));
 
             SV_BufferRemoveFormat(input, "bsBss",
                 &packet->request.id,
@@ -422,7 +465,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVTransaction: {
-            SVPacketTransaction* packet = (SVPacketTransaction*) CD_malloc(sizeof(SVPacketTransaction));
+            SVPacketTransaction* packet = (SVPacketTransaction*) CD_PoolsAlloc(sizeof(SVPacketTransaction));
 
             SV_BufferRemoveFormat(input, "bsB",
                 &packet->request.id,
@@ -434,7 +477,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVUpdateSign: {
-            SVPacketUpdateSign* packet = (SVPacketUpdateSign*) CD_malloc(sizeof(SVPacketUpdateSign));
+            SVPacketUpdateSign* packet = (SVPacketUpdateSign*) CD_PoolsAlloc(sizeof(SVPacketUpdateSign));
 
             SV_BufferRemoveFormat(input, "iisiUUUU",
                 &packet->request.position.x,
@@ -451,7 +494,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVIncrementStatistic: {
-            SVPacketIncrementStatistic* packet = (SVPacketIncrementStatistic*) CD_malloc(sizeof(SVPacketIncrementStatistic));
+            SVPacketIncrementStatistic* packet = (SVPacketIncrementStatistic*) CD_PoolsAlloc(sizeof(SVPacketIncrementStatistic));
 
             SV_BufferRemoveFormat(input, "ib",
                 &packet->request.id,
@@ -462,7 +505,7 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
         }
 
         case SVDisconnect: {
-            SVPacketDisconnect* packet = (SVPacketDisconnect*) CD_malloc(sizeof(SVPacketDisconnect));
+            SVPacketDisconnect* packet = (SVPacketDisconnect*) CD_PoolsAlloc(sizeof(SVPacketDisconnect));
 
             packet->request.reason = SV_BufferRemoveString16(input);
 
@@ -478,9 +521,14 @@ SV_GetPacketDataFromBuffer (SVPacket* self, CDBuffer* input)
 CDBuffer*
 SV_PacketToBuffer (SVPacket* self)
 {
-    CDBuffer* data = CD_CreateBuffer();
+    return SV_PacketAddToBuffer(self, CD_CreateBuffer());
+}
 
+CDBuffer*
+SV_PacketAddToBuffer (SVPacket* self, CDBuffer* data)
+{
     assert(self);
+    assert(data);
 
     SV_BufferAddByte(data, self->type);
 
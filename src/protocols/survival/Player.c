@@ -88,11 +88,7 @@ SV_PlayerSendPacket (SVPlayer* self, SVPacket* packet)
         return;
     }
 
-    CDBuffer* data = SV_PacketToBuffer(packet);
-
-    CD_ClientSendBuffer(self->client, data);
-
-    CD_DestroyBuffer(data);
+    CD_ClientSendBuffer(self->client, SV_PacketAddToBuffer(packet, CD_ArenaBuffer()));
 }
 
 void
@@ -102,11 +98,8 @@ SV_PlayerSendPacketAndClean (SVPlayer* self, SVPacket* packet)
         return;
     }
 
-    CDBuffer* data = SV_PacketToBuffer(packet);
+    CD_ClientSendBuffer(self->client, SV_PacketAddToBuffer(packet, CD_ArenaBuffer()));
 
-    CD_ClientSendBuffer(self->client, data);
-
-    CD_DestroyBuffer(data);
     SV_DestroyPacket(packet);
 }
 
@@ -117,10 +110,7 @@ SV_PlayerSendPacketAndCleanData (SVPlayer* self, SVPacket* packet)
         return;
     }
 
-    CDBuffer* data = SV_PacketToBuffer(packet);
-
-    CD_ClientSendBuffer(self->client, data);
+    CD_ClientSendBuffer(self->client, SV_PacketAddToBuffer(packet, CD_ArenaBuffer()));
 
-    CD_DestroyBuffer(data);
     SV_DestroyPacketData(packet);
 }
@@ -58,15 +58,21 @@ SV_RelativeMove (SVPrecisePosition* a, SVPrecisePosition* b)
 void
 SV_RegionBroadcastPacket (SVPlayer* player, SVPacket* packet)
 {
-    CDList* seenPlayers = (CDList*) CD_DynamicGet(player, "Player.seenPlayers");
+    CDList*         seenPlayers = (CDList*) CD_DynamicGet(player, "Player.seenPlayers");
+    CDBuffer*       buffer      = SV_PacketAddToBuffer(packet, CD_ArenaBuffer());
+    CDSharedBuffer* shared      = CD_CreateSharedBuffer(buffer);
 
     CD_LIST_FOREACH(seenPlayers, it) {
-        if (player == (SVPlayer*) CD_ListIteratorValue(it)) {
+        SVPlayer* other = (SVPlayer*) CD_ListIteratorValue(it);
+
+        if (player == other || !other->client) {
             continue;
         }
 
-        SV_PlayerSendPacket((SVPlayer*) CD_ListIteratorValue(it), packet);
+        CD_ClientSendSharedBuffer(other->client, shared);
     }
+
+    CD_SharedBufferRelease(shared);
 }
 
 
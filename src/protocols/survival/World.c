@@ -49,10 +49,10 @@ SV_CreateWorld (CDServer* server, const char* name)
     self->dimension = SVWorldNormal;
     self->time      = 0;
 
-    self->players  = CD_CreateHash();
+    self->players  = CD_CreateHashWith(CDHashStriped);
     self->entities = CD_CreateMap();
 
-    self->chunks = CD_CreateHash();
+    self->chunks = CD_CreateHashWith(CDHashStriped);
 
     self->lastGeneratedEntityId = 0;
 
@@ -189,15 +189,19 @@ SV_WorldBroadcastBuffer (SVWorld* self, CDBuffer* buffer)
 {
     assert(self);
 
+    CDSharedBuffer* shared = CD_CreateSharedBuffer(buffer);
+
     CD_HASH_FOREACH(self->players, it) {
         SVPlayer* player = (SVPlayer*) CD_HashIteratorValue(it);
 
         pthread_rwlock_rdlock(&player->client->lock.status);
         if (player->client->status != CDClientDisconnect) {
-            CD_ClientSendBuffer(player->client, buffer);
+            CD_ClientSendSharedBuffer(player->client, shared);
         }
         pthread_rwlock_unlock(&player->client->lock.status);
     }
+
+    CD_SharedBufferRelease(shared);
 }
 
 void
@@ -205,11 +209,7 @@ SV_WorldBroadcastPacket (SVWorld* self, SVPacket* packet)
 {
     assert(self);
 
-    CDBuffer* buffer = SV_PacketToBuffer(packet);
-
-    SV_WorldBroadcastBuffer(self, buffer);
-
-    CD_DestroyBuffer(buffer);
+    SV_WorldBroadcastBuffer(self, SV_PacketAddToBuffer(packet, CD_ArenaBuffer()));
 }
 
 void
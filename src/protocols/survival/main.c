@@ -28,7 +28,8 @@
 CDProtocol*
 CD_InitializeSurvivalProtocol (CDServer* server)
 {
-    server->protocol = CD_CreateProtocol("survival", SV_PacketParsable, (CDProtocolPacketParse) SV_PacketFromBuffers);
+    server->protocol = CD_CreateProtocol("survival", SV_PacketParsable, (CDProtocolPacketParse) SV_PacketFromBuffers,
+        (CDProtocolPacketDestroy) SV_DestroyPacket, (CDProtocolPacketPriority) SV_PacketPriority);
 
     CD_EventProvides(server, "Client.process",   CD_CreateEventParameters("CDClient", "SVPacket", NULL));
     CD_EventProvides(server, "Client.processed", CD_CreateEventParameters("CDClient", "SVPacket", NULL));
@@ -112,72 +112,112 @@ SV_AppendData (SVMetadata* metadata, SVData* data)
     return metadata;
 }
 
+static inline
+size_t
+sv_CharLength (const char* data)
+{
+    size_t length = CD_UTF8_offset(data, 1);
+
+    return (length > 0) ? length : 1;
+}
+
+static inline
+bool
+sv_CharsetHas (const char* ch, size_t size)
+{
+    for (const char* che = SVCharset; *che != '\0'; che += sv_CharLength(che)) {
+        if (strncmp(ch, che, size) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static inline
+bool
+sv_CharIsColor (const char* ch, size_t size)
+{
+    return size == 2 && strncmp(ch, "§", 2) == 0;
+}
+
 bool
 SV_StringIsValid (SVString self)
 {
     assert(self);
 
-    for (size_t i = 0, ie = CD_StringLength(self); i < ie; i++) {
-        bool      has = false;
-        CDString* ch  = CD_CharAt(self, i);
-
-        for (size_t h = 0, he = CD_UTF8_strlen(SVCharset); h < he; h++) {
-            const char* che = &SVCharset[CD_UTF8_offset(SVCharset, h)];
+    const char* data = CD_StringContent(self);
+    const char* end  = data + CD_StringSize(self);
 
-            if (strncmp(CD_StringContent(ch), che, CD_StringSize(ch)) == 0) {
-                has = true;
-                break;
-            }
-        }
+    for (size_t i = 0, ie = CD_StringLength(self); i < ie && data < end; i++) {
+        size_t size = sv_CharLength(data);
 
-        if (!has && !(strncmp(CD_StringContent(ch), "§", 2) == 0 && i < ie - 2)) {
-            CD_DestroyString(ch);
+        if (!sv_CharsetHas(data, size) && !(sv_CharIsColor(data, size) && i < ie - 2)) {
             return false;
         }
 
-        CD_DestroyString(ch);
+        data += size;
     }
 
     return true;
 }
 
-SVString
-SV_StringSanitize (SVString self)
+size_t
+SV_StringSanitizeInto (SVString self, char* output)
 {
-    CDString* result = CD_CreateString();
-
     assert(self);
+    assert(output);
 
-    for (size_t i = 0, ie = CD_StringLength(self); i < ie; i++) {
-        bool      has = false;
-        CDString* ch  = CD_CharAt(self, i);
+    const char* data   = CD_StringContent(self);
+    const char* end    = data + CD_StringSize(self);
+    size_t      length = 0;
 
-        for (size_t h = 0, he = CD_UTF8_strlen(SVCharset); h < he; h++) {
-            const char* che = &SVCharset[CD_UTF8_offset(SVCharset, h)];
+    for (size_t i = 0, ie = CD_StringLength(self); i < ie && data < end; i++) {
+        size_t size = sv_CharLength(data);
 
-            if (strncmp(CD_StringContent(ch), che, CD_StringSize(ch)) == 0) {
-                has = true;
+        if (size > (size_t) (end - data)) {
+            size = end - data;
+        }
+
+        if (sv_CharIsColor(data, size)) {
+            // A color code without anything to color
+            if (i == ie - 2) {
                 break;
             }
-        }
 
-        if (i == ie - 2 && strncmp(CD_StringContent(ch), "§", 2) == 0){
-            CD_DestroyString(ch);
-            break;
+            memcpy(output + length, data, size);
+            length += size;
         }
-
-        if (has || strncmp(CD_StringContent(ch), "§", 2) == 0) {
-            CD_AppendString(result, ch);
+        else if (sv_CharsetHas(data, size)) {
+            memcpy(output + length, data, size);
+            length += size;
         }
         else {
-            CD_AppendCString(result, "?");
+            output[length++] = '?';
         }
 
-        CD_DestroyString(ch);
+        data += size;
     }
 
+    output[length] = '\0';
+
     self->length = CD_UTF8_strnlen(CD_StringContent(self), self->raw->slen);
 
+    return length;
+}
+
+SVString
+SV_StringSanitize (SVString self)
+{
+    assert(self);
+
+    CDArenaMark mark   = CD_ArenaSave();
+    char*       output = CD_ArenaAlloc(CD_StringSize(self) + 1);
+    size_t      length = SV_StringSanitizeInto(self, output);
+    CDString*   result = CD_CreateStringFromBufferCopy(output, length);
+
+    CD_ArenaRestore(mark);
+
     return result;
 }
 
@@ -231,11 +271,11 @@ unsigned int
 SV_HashChunkPosition (CDSet* self, SVChunkPosition* position)
 {
     const int HASHMULTIPLIER = 31;
-    const int CHUNKBUCKETS   = 401; // Max chunks to the nearest prime
 
     assert(self);
 
-    return ((((position->x * HASHMULTIPLIER)) * HASHMULTIPLIER + position->z) * HASHMULTIPLIER) % CHUNKBUCKETS;
+    // The Set spreads the bits itself, folding them here would only add collisions
+    return (((position->x * HASHMULTIPLIER)) * HASHMULTIPLIER + position->z) * HASHMULTIPLIER;
 }
 
 void
@@ -24,6 +24,7 @@
  */
 
 #include <craftd/common.h>
+#include <time.h>
 
 void
 CD_abort (const char* error, ...)
@@ -37,6 +38,16 @@ CD_abort (const char* error, ...)
     abort();
 }
 
+uint64_t
+CD_MonotonicTime (void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
 int
 CD_mkdir (const char* path, mode_t mode)
 {